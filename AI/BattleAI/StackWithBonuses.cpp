@@ -109,10 +109,10 @@ SlotID StackWithBonuses::unitSlot() const
 }
 
 TConstBonusListPtr StackWithBonuses::getAllBonuses(const CSelector & selector, const CSelector & limit,
-	const CBonusSystemNode * root, const std::string & cachingStr) const
+	const CBonusSystemNode * root, const BonusCacheKey & cachingKey) const
 {
 	TBonusListPtr ret = std::make_shared<BonusList>();
-	TConstBonusListPtr originalList = origBearer->getAllBonuses(selector, limit, root, cachingStr);
+	TConstBonusListPtr originalList = origBearer->getAllBonuses(selector, limit, root, cachingKey);
 
 	vstd::copy_if(*originalList, std::back_inserter(*ret), [this](const std::shared_ptr<Bonus> & b)
 	{
@@ -417,7 +417,8 @@ int64_t HypotheticBattle::getActualDamage(const TDmgRange & damage, int32_t atta
 
 int64_t HypotheticBattle::getTreeVersion() const
 {
-	return getBattleNode()->getTreeVersion() + bonusTreeVersion;
+	//units may inherit bonuses from nodes outside of battle subtree, e.g. their heroes or artifacts
+	return CBonusSystemNode::getGlobalTreeVersion() + bonusTreeVersion;
 }
 
 Pool * HypotheticBattle::getContextPool() const
@@ -69,7 +69,7 @@ public:
 
 	///IBonusBearer
 	TConstBonusListPtr getAllBonuses(const CSelector & selector, const CSelector & limit,
-		const CBonusSystemNode * root = nullptr, const std::string & cachingStr = "") const override;
+		const CBonusSystemNode * root = nullptr, const BonusCacheKey & cachingKey = BonusCacheKey()) const override;
 
 	int64_t getTreeVersion() const override;
 
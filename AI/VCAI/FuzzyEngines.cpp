@@ -53,13 +53,13 @@ armyStructure evaluateArmyStructure(const CArmedInstance * army)
 	ui32 maxSpeed = 0;
 
 	static const CSelector selectorSHOOTER = Selector::type()(Bonus::SHOOTER);
-	static const std::string keySHOOTER = "type_"+std::to_string((int32_t)Bonus::SHOOTER);
+	static const auto keySHOOTER = BonusCacheKey::type(Bonus::SHOOTER);
 
 	static const CSelector selectorFLYING = Selector::type()(Bonus::FLYING);
-	static const std::string keyFLYING = "type_"+std::to_string((int32_t)Bonus::FLYING);
+	static const auto keyFLYING = BonusCacheKey::type(Bonus::FLYING);
 
 	static const CSelector selectorSTACKS_SPEED = Selector::type()(Bonus::STACKS_SPEED);
-	static const std::string keySTACKS_SPEED = "type_"+std::to_string((int32_t)Bonus::STACKS_SPEED);
+	static const auto keySTACKS_SPEED = BonusCacheKey::type(Bonus::STACKS_SPEED);
 
 	for(auto s : army->Slots())
 	{
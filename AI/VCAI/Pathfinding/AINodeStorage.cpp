@@ -20,7 +20,6 @@
 AINodeStorage::AINodeStorage(const int3 & Sizes)
 	: sizes(Sizes)
 {
-	nodes.resize(boost::extents[sizes.x][sizes.y][sizes.z][EPathfindingLayer::NUM_LAYERS][NUM_CHAINS]);
 	dangerEvaluator.reset(new FuzzyHelper());
 }
 
@@ -28,46 +27,13 @@ AINodeStorage::~AINodeStorage() = default;
 
 void AINodeStorage::initialize(const PathfinderOptions & options, const CGameState * gs, const CGHeroInstance * hero)
 {
-	//TODO: fix this code duplication with NodeStorage::initialize, problem is to keep `resetTile` inline
+	specialActions.clear();
+	specialActions.push_back(nullptr);
 
-	int3 pos;
-	const int3 sizes = gs->getMapSize();
-	const auto & fow = static_cast<const CGameInfoCallback *>(gs)->getPlayerTeam(hero->tempOwner)->fogOfWarMap;
-	const PlayerColor player = hero->tempOwner;
-
-	//make 200% sure that these are loop invariants (also a bit shorter code), let compiler do the rest(loop unswitching)
-	const bool useFlying = options.useFlying;
-	const bool useWaterWalking = options.useWaterWalking;
-
-	for(pos.x=0; pos.x < sizes.x; ++pos.x)
+	PathfinderUtil::evaluateTiles(options, gs, hero, [this](const int3 & pos, ELayer layer, CGPathNode::EAccessibility accessibility)
 	{
-		for(pos.y=0; pos.y < sizes.y; ++pos.y)
-		{
-			for(pos.z=0; pos.z < sizes.z; ++pos.z)
-			{
-				const TerrainTile * tile = &gs->map->getTile(pos);
-				switch(tile->terType)
-				{
-				case ETerrainType::ROCK:
-					break;
-
-				case ETerrainType::WATER:
-					resetTile(pos, ELayer::SAIL, PathfinderUtil::evaluateAccessibility<ELayer::SAIL>(pos, tile, fow, player, gs));
-					if(useFlying)
-						resetTile(pos, ELayer::AIR, PathfinderUtil::evaluateAccessibility<ELayer::AIR>(pos, tile, fow, player, gs));
-					if(useWaterWalking)
-						resetTile(pos, ELayer::WATER, PathfinderUtil::evaluateAccessibility<ELayer::WATER>(pos, tile, fow, player, gs));
-					break;
-
-				default:
-					resetTile(pos, ELayer::LAND, PathfinderUtil::evaluateAccessibility<ELayer::LAND>(pos, tile, fow, player, gs));
-					if(useFlying)
-						resetTile(pos, ELayer::AIR, PathfinderUtil::evaluateAccessibility<ELayer::AIR>(pos, tile, fow, player, gs));
-					break;
-				}
-			}
-		}
-	}
+		resetTile(pos, layer, accessibility);
+	});
 }
 
 const AIPathNode * AINodeStorage::getAINode(const CGPathNode * node) const
@@ -82,6 +48,25 @@ void AINodeStorage::updateAINode(CGPathNode * node, std::function<void(AIPathNod
 	updater(aiNode);
 }
 
+std::shared_ptr<const ISpecialAction> AINodeStorage::getSpecialAction(const CGPathNode * node) const
+{
+	return specialActions[getAINode(node)->specialAction];
+}
+
+void AINodeStorage::setSpecialAction(CGPathNode * node, std::shared_ptr<const ISpecialAction> action)
+{
+	auto aiNode = static_cast<AIPathNode *>(node);
+
+	if(!action)
+	{
+		aiNode->specialAction = 0;
+		return;
+	}
+
+	aiNode->specialAction = static_cast<uint32_t>(specialActions.size());
+	specialActions.push_back(action);
+}
+
 bool AINodeStorage::isBattleNode(const CGPathNode * node) const
 {
 	return (getAINode(node)->chainMask & BATTLE_CHAIN) > 0;
@@ -89,9 +74,7 @@ bool AINodeStorage::isBattleNode(const CGPathNode * node) const
 
 boost::optional<AIPathNode *> AINodeStorage::getOrCreateNode(const int3 & pos, const EPathfindingLayer layer, int chainNumber)
 {
-	auto chains = nodes[pos.x][pos.y][pos.z][layer];
-
-	for(AIPathNode & node : chains)
+	for(AIPathNode & node : getChains(pos, layer))
 	{
 		if(node.chainMask == chainNumber)
 		{
@@ -126,14 +109,15 @@ CGPathNode * AINodeStorage::getInitialNode()
 
 void AINodeStorage::resetTile(const int3 & coord, EPathfindingLayer layer, CGPathNode::EAccessibility accessibility)
 {
-	for(int i = 0; i < NUM_CHAINS; i++)
-	{
-		AIPathNode & heroNode = nodes[coord.x][coord.y][coord.z][layer][i];
+	if(nodes[layer].empty())
+		nodes[layer].resize(sizes.x * sizes.y * sizes.z * NUM_CHAINS);
 
+	for(AIPathNode & heroNode : getChains(coord, layer))
+	{
 		heroNode.chainMask = 0;
 		heroNode.danger = 0;
 		heroNode.manaCost = 0;
-		heroNode.specialAction.reset();
+		heroNode.specialAction = 0;
 		heroNode.update(coord, layer, accessibility);
 	}
 }
@@ -154,7 +138,7 @@ void AINodeStorage::commit(CDestinationNodeInfo & destination, const PathNodeInf
 
 		if(dstNode->specialAction)
 		{
-			dstNode->specialAction->applyOnDestination(getHero(), destination, source, dstNode, srcNode);
+			specialActions[dstNode->specialAction]->applyOnDestination(getHero(), destination, source, dstNode, srcNode);
 		}
 	});
 }
@@ -280,7 +264,7 @@ void AINodeStorage::calculateTownPortalTeleportations(
 				AIPathNode * node = nodeOptional.get();
 
 				node->theNodeBefore = source.node;
-				node->specialAction.reset(new AIPathfinding::TownPortalAction(targetTown));
+				setSpecialAction(node, std::make_shared<const AIPathfinding::TownPortalAction>(targetTown));
 				node->moveRemains = source.node->moveRemains;
 				
 				neighbours.push_back(node);
@@ -291,11 +275,9 @@ void AINodeStorage::calculateTownPortalTeleportations(
 
 bool AINodeStorage::hasBetterChain(const PathNodeInfo & source, CDestinationNodeInfo & destination) const
 {
-	auto pos = destination.coord;
-	auto chains = nodes[pos.x][pos.y][pos.z][EPathfindingLayer::LAND];
 	auto destinationNode = getAINode(destination.node);
 
-	for(const AIPathNode & node : chains)
+	for(const AIPathNode & node : getChains(destination.coord, EPathfindingLayer::LAND))
 	{
 		auto sameNode = node.chainMask == destinationNode->chainMask;
 		if(sameNode	|| node.action == CGPathNode::ENodeAction::UNKNOWN)
@@ -325,18 +307,17 @@ bool AINodeStorage::hasBetterChain(const PathNodeInfo & source, CDestinationNode
 
 bool AINodeStorage::isTileAccessible(const int3 & pos, const EPathfindingLayer layer) const
 {
-	const AIPathNode & node = nodes[pos.x][pos.y][pos.z][layer][0];
+	auto chains = getChains(pos, layer);
 
-	return node.action != CGPathNode::ENodeAction::UNKNOWN;
+	return !chains.empty() && chains.front().action != CGPathNode::ENodeAction::UNKNOWN;
 }
 
 std::vector<AIPath> AINodeStorage::getChainInfo(const int3 & pos, bool isOnLand) const
 {
 	std::vector<AIPath> paths;
-	auto chains = nodes[pos.x][pos.y][pos.z][isOnLand ? EPathfindingLayer::LAND : EPathfindingLayer::SAIL];
 	auto initialPos = hero->visitablePos();
 
-	for(const AIPathNode & node : chains)
+	for(const AIPathNode & node : getChains(pos, isOnLand ? EPathfindingLayer::LAND : EPathfindingLayer::SAIL))
 	{
 		if(node.action == CGPathNode::ENodeAction::UNKNOWN)
 		{
@@ -355,7 +336,7 @@ std::vector<AIPath> AINodeStorage::getChainInfo(const int3 & pos, bool isOnLand)
 			pathNode.coord = current->coord;
 
 			path.nodes.push_back(pathNode);
-			path.specialAction = current->specialAction;
+			path.specialAction = specialActions[current->specialAction];
 
 			current = getAINode(current->theNodeBefore);
 		}
@@ -19,10 +19,10 @@
 
 struct AIPathNode : public CGPathNode
 {
-	uint32_t chainMask;
 	uint64_t danger;
+	uint32_t chainMask;
 	uint32_t manaCost;
-	std::shared_ptr<const ISpecialAction> specialAction;
+	uint32_t specialAction; //index in AINodeStorage special actions table, 0 if there is no action
 };
 
 struct AIPathNodeInfo
@@ -57,8 +57,10 @@ class AINodeStorage : public INodeStorage
 private:
 	int3 sizes;
 
-	/// 1-3 - position on map, 4 - layer (air, water, land), 5 - chain (normal, battle, spellcast and combinations)
-	boost::multi_array<AIPathNode, 5> nodes;
+	/// [layer][level][h][w][chain] (chain: normal, battle, spellcast and combinations), layer is allocated on first use
+	std::array<std::vector<AIPathNode>, EPathfindingLayer::NUM_LAYERS> nodes;
+	/// actions are rare, so nodes keep only index in this table. Element 0 is always null
+	std::vector<std::shared_ptr<const ISpecialAction>> specialActions;
 	const CPlayerSpecificInfoCallback * cb;
 	const VCAI * ai;
 	const CGHeroInstance * hero;
@@ -67,6 +69,24 @@ private:
 	STRONG_INLINE
 	void resetTile(const int3 & tile, EPathfindingLayer layer, CGPathNode::EAccessibility accessibility);
 
+	/// Returns empty range if layer is not used by this pathfinder
+	STRONG_INLINE
+	boost::iterator_range<AIPathNode *> getChains(const int3 & pos, EPathfindingLayer layer)
+	{
+		auto & layerNodes = nodes[layer];
+		if(layerNodes.empty())
+			return boost::iterator_range<AIPathNode *>();
+
+		AIPathNode * first = layerNodes.data() + ((pos.z * sizes.y + pos.y) * sizes.x + pos.x) * NUM_CHAINS;
+		return boost::make_iterator_range(first, first + NUM_CHAINS);
+	}
+
+	boost::iterator_range<const AIPathNode *> getChains(const int3 & pos, EPathfindingLayer layer) const
+	{
+		auto chains = const_cast<AINodeStorage *>(this)->getChains(pos, layer);
+		return boost::make_iterator_range<const AIPathNode *>(chains.begin(), chains.end());
+	}
+
 public:
 	/// more than 1 chain layer allows us to have more than 1 path to each tile so we can chose more optimal one.
 	static const int NUM_CHAINS = 3;
@@ -98,6 +118,8 @@ public:
 
 	const AIPathNode * getAINode(const CGPathNode * node) const;
 	void updateAINode(CGPathNode * node, std::function<void (AIPathNode *)> updater);
+	std::shared_ptr<const ISpecialAction> getSpecialAction(const CGPathNode * node) const;
+	void setSpecialAction(CGPathNode * node, std::shared_ptr<const ISpecialAction> action);
 
 	bool isBattleNode(const CGPathNode * node) const;
 	bool hasBetterChain(const PathNodeInfo & source, CDestinationNodeInfo & destination) const;
@@ -124,7 +124,7 @@ namespace AIPathfinding
 
 				if(boatNode->action == CGPathNode::UNKNOWN)
 				{
-					boatNode->specialAction = virtualBoat;
+					nodeStorage->setSpecialAction(boatNode, virtualBoat);
 					destination.blocked = false;
 					destination.action = CGPathNode::ENodeAction::EMBARK;
 					destination.node = boatNode;
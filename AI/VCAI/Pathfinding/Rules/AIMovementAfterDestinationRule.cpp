@@ -131,7 +131,7 @@ namespace AIPathfinding
 				battleNode->danger = danger;
 			}
 
-			battleNode->specialAction = std::make_shared<BattleAction>(destination.coord);
+			nodeStorage->setSpecialAction(battleNode, std::make_shared<BattleAction>(destination.coord));
 #ifdef VCMI_TRACE_PATHFINDER
 			logAi->trace(
 				"Begin bypass guard at destination with danger %s while moving %s -> %s",
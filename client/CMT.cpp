@@ -789,6 +789,23 @@ void processCommand(const std::string &message)
 			std::cout << "\nBonuses from " << typeid(*parent).name() << std::endl << format(*parent->getAllBonuses(Selector::all, Selector::all)) << std::endl;
 		}
 	}
+	else if(cn == "netstats" && CSH->c)
+	{
+		auto print = [](const std::string & title, const CConnection::TrafficStatistics & traffic)
+		{
+			std::cout << title << std::endl;
+			for(auto & entry : traffic)
+				std::cout << "\t" << entry.first << ": " << entry.second.packets << " packs, " << entry.second.bytes << " bytes" << std::endl;
+		};
+		print("Sent:", CSH->c->getSentTraffic());
+		print("Received:", CSH->c->getReceivedTraffic());
+	}
+	else if(cn == "animcache")
+	{
+		auto stats = CAnimation::getFileCacheStatistics();
+		std::cout << "Def file cache: " << stats.files << " files, " << stats.bytes << " bytes" << std::endl;
+		std::cout << "\t" << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions << " evictions" << std::endl;
+	}
 	else if(cn == "not dialog")
 	{
 		LOCPLINT->showingDialog->setn(false);
@@ -1221,6 +1238,8 @@ static bool recreateWindow(int w, int h, int bpp, bool fullscreen, int displayIn
 
 	screenBuf = bufOnScreen ? screen : screen2;
 
+	GH.invalidateScreen();
+
 	SDL_SetRenderDrawColor(mainRenderer, 0, 0, 0, 0);
 	SDL_RenderClear(mainRenderer);
 	SDL_RenderPresent(mainRenderer);
@@ -1352,6 +1371,9 @@ static void handleEvent(SDL_Event & ev)
 		case SDL_WINDOWEVENT_RESTORED:
 			fullScreenChanged();
 			break;
+		case SDL_WINDOWEVENT_EXPOSED:
+			GH.invalidateScreen();
+			break;
 		}
 		return;
 	}
@@ -1400,9 +1422,14 @@ void handleQuit(bool ask)
 		if(CSH->client)
 			CSH->endGameplay();
 
+		CSaveFile::waitForPendingWrites();
+
 		GH.listInt.clear();
 		GH.objsToBlit.clear();
 
+		//workers use filesystem and logging, that are destroyed below
+		CAnimation::stopDecoding();
+
 		CMM.reset();
 
 		// cleanup, mostly to remove false leaks from analyzer
@@ -427,6 +427,8 @@ bool CVideoPlayer::openAndPlayVideo(std::string name, int x, int y, bool stopOnK
 	open(name, false, true, scale);
 	bool ret = playVideo(x, y,  stopOnKey);
 	close();
+	// video was presented bypassing screen texture
+	GH.invalidateScreen();
 	return ret;
 }
 
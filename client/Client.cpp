@@ -409,6 +409,7 @@ void CClient::initMapHandler()
 	}
 
 	pathCache.clear();
+	outdatedPaths.clear();
 }
 
 void CClient::initPlayerEnvironments()
@@ -707,7 +708,17 @@ void CClient::waitForMoveAndSend(PlayerColor color)
 void CClient::invalidatePaths()
 {
 	boost::unique_lock<boost::mutex> pathLock(pathCacheMutex);
+
+	for(auto & paths : pathCache)
+		outdatedPaths[paths.first] = paths.second;
+
 	pathCache.clear();
+
+	//hero may have been removed from map or replaced by another object
+	vstd::erase_if(outdatedPaths, [this](const std::pair<const ObjectInstanceID, std::shared_ptr<CPathsInfo>> & paths)
+	{
+		return getHero(paths.first) != paths.second->hero;
+	});
 }
 
 std::shared_ptr<const CPathsInfo> CClient::getPathsInfo(const CGHeroInstance * h)
@@ -715,15 +726,28 @@ std::shared_ptr<const CPathsInfo> CClient::getPathsInfo(const CGHeroInstance * h
 	assert(h);
 	boost::unique_lock<boost::mutex> pathLock(pathCacheMutex);
 
-	auto iter = pathCache.find(h);
+	auto iter = pathCache.find(h->id);
 
 	if(iter == std::end(pathCache))
 	{
-		std::shared_ptr<CPathsInfo> paths = std::make_shared<CPathsInfo>(getMapSize(), h);
+		std::shared_ptr<CPathsInfo> paths;
+
+		//pathfinder updates old paths incrementally if possible, but they must not be in use anymore
+		auto outdated = outdatedPaths.find(h->id);
+		if(outdated != std::end(outdatedPaths))
+		{
+			if(outdated->second.use_count() == 1 && outdated->second->hero == h)
+				paths = outdated->second;
+
+			outdatedPaths.erase(outdated);
+		}
+
+		if(!paths)
+			paths = std::make_shared<CPathsInfo>(getMapSize(), h);
 
 		gs->calculatePaths(h, *paths.get());
 
-		pathCache[h] = paths;
+		pathCache[h->id] = paths;
 		return paths;
 	}
 	else
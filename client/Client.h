@@ -245,7 +245,8 @@ private:
 	std::shared_ptr<CApplier<CBaseForCLApply>> applier;
 
 	mutable boost::mutex pathCacheMutex;
-	std::map<const CGHeroInstance *, std::shared_ptr<CPathsInfo>> pathCache;
+	std::map<ObjectInstanceID, std::shared_ptr<CPathsInfo>> pathCache;
+	std::map<ObjectInstanceID, std::shared_ptr<CPathsInfo>> outdatedPaths; //invalidated, but can be updated incrementally
 
 	std::map<PlayerColor, std::shared_ptr<boost::thread>> playerActionThreads;
 
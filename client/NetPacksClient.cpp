@@ -766,6 +766,11 @@ void SaveGameClient::applyCl(CClient *cl)
 		CSaveFile save(*CResourceHandler::get()->getResourceName(ResourceID(stem.to_string(), EResType::CLIENT_SAVEGAME)));
 		cl->saveCommonState(save);
 		save << *cl;
+		save.onWritten([](const std::string & error)
+		{
+			if(!error.empty())
+				logNetwork->error("Failed to save game: %s", error);
+		});
 	}
 	catch(std::exception &e)
 	{
@@ -135,6 +135,12 @@ CBattleInterface::CBattleInterface(const CCreatureSet *army1, const CCreatureSet
 	//if we found interface of player with tactics, then enter tactics mode
 	tacticsMode = static_cast<bool>(tacticianInterface);
 
+	//creature animations are read on worker threads while rest of interface is created
+	std::vector<std::string> stackAnimations;
+	for(const CStack * s : curInt->cb->battleGetAllStacks(true))
+		stackAnimations.push_back(s->getCreature()->animDefName);
+	CAnimation::prefetchFiles(stackAnimations);
+
 	//create stack queue
 
 	bool embedQueue;
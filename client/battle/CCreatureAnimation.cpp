@@ -164,7 +164,9 @@ CCreatureAnimation::CCreatureAnimation(const std::string & name_, TSpeedControll
 	forward = std::make_shared<CAnimation>(name_);
 	reverse = std::make_shared<CAnimation>(name_);
 
-	//todo: optimize
+	//both copies are decoded on worker threads in parallel with main thread
+	forward->prefetch();
+	reverse->prefetch();
 	forward->preload();
 	reverse->preload();
 
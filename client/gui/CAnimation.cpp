@@ -11,6 +11,9 @@
 #include "CAnimation.h"
 
 #include <SDL_image.h>
+#include <boost/crc.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
 #include "../CBitmapHandler.h"
 #include "../Graphics.h"
@@ -19,10 +22,15 @@
 
 #include "../lib/filesystem/Filesystem.h"
 #include "../lib/filesystem/ISimpleResourceLoader.h"
+#include "../lib/filesystem/FileStream.h"
+#include "../lib/CConfigHandler.h"
+#include "../lib/VCMIDirs.h"
 #include "../lib/JsonNode.h"
 #include "../lib/CRandomGenerator.h"
+#include "../lib/CThreadHelper.h"
 
 class SDLImageLoader;
+class CSpriteAtlas;
 
 typedef std::map <size_t, std::vector <JsonNode> > source_map;
 typedef std::map<size_t, IImage* > image_map;
@@ -45,12 +53,17 @@ private:
 		si32 leftMargin;
 		si32 topMargin;
 	} PACKED_STRUCT;
-	//offset[group][frame] - offset of frame data in file
+	//offset[group][frame] - offset of frame data in file, or index of frame in atlas
 	std::map<size_t, std::vector <size_t> > offset;
 
-	std::unique_ptr<ui8[]>       data;
+	std::shared_ptr<const ui8>   data; //whole file, shared with file cache
 	std::unique_ptr<SDL_Color[]> palette;
 
+	std::shared_ptr<const CSpriteAtlas> atlas; //decoded frames from disk cache, used instead of data if present
+	boost::optional<ui32> fingerprint; //key of disk cache, if it is enabled
+
+	void initFromAtlas();
+
 public:
 	CDefFile(std::string Name);
 	~CDefFile();
@@ -60,6 +73,10 @@ public:
 	void loadFrame(size_t frame, size_t group, ImageLoader &loader) const;
 
 	const std::map<size_t, size_t> getEntries() const;
+
+	//true if frames were decoded from def file and disk cache has no valid copy of them
+	bool shouldBeCached() const;
+	boost::optional<ui32> getFingerprint() const;
 };
 
 
@@ -135,47 +152,100 @@ public:
 	~SDLImageLoader();
 };
 
-// Extremely simple file cache. TODO: smarter, more general solution
+// LRU cache of raw def files, limited by total size of cached files
 class CFileCache
 {
-	static const int cacheSize = 50; //Max number of cached files
+	static const size_t cacheBudget = 32 * 1024 * 1024; //Max total size of cached files in bytes
 	struct FileData
 	{
-		ResourceID             name;
-		size_t                 size;
-		std::unique_ptr<ui8[]> data;
+		ResourceID                 name;
+		size_t                     size;
+		std::shared_ptr<const ui8> data; //read-only, shared with all users of the file
 
-		std::unique_ptr<ui8[]> getCopy()
-		{
-			auto ret = std::unique_ptr<ui8[]>(new ui8[size]);
-			std::copy(data.get(), data.get() + size, ret.get());
-			return ret;
-		}
-		FileData(ResourceID name_, size_t size_, std::unique_ptr<ui8[]> data_):
+		FileData(ResourceID name_, size_t size_, std::shared_ptr<const ui8> data_):
 			name{std::move(name_)},
 			size{size_},
 			data{std::move(data_)}
 		{}
 	};
 
-	std::deque<FileData> cache;
+	std::list<FileData> cache; //most recently used first
+	std::unordered_map<ResourceID, std::list<FileData>::iterator> index;
+	std::unordered_set<ResourceID> loading; //files being read by some thread right now
+	size_t cachedBytes = 0;
+	CAnimation::FileCacheStatistics statistics = {};
+	mutable boost::mutex mx;
+	boost::condition_variable loaded;
+
+	void evict()
+	{
+		//most recent file is kept even if it alone exceeds budget
+		while(cachedBytes > cacheBudget && cache.size() > 1)
+		{
+			const FileData & file = cache.back();
+			logAnim->trace("Evicting %s from file cache", file.name.getName());
+			cachedBytes -= file.size;
+			index.erase(file.name);
+			cache.pop_back();
+			statistics.evictions++;
+		}
+	}
 public:
-	std::unique_ptr<ui8[]> getCachedFile(ResourceID rid)
+	std::shared_ptr<const ui8> getCachedFile(const ResourceID & rid)
 	{
-		for(auto & file : cache)
+		boost::unique_lock<boost::mutex> lock(mx);
+
+		while(true)
 		{
-			if (file.name == rid)
-				return file.getCopy();
+			auto found = index.find(rid);
+			if(found != index.end())
+			{
+				statistics.hits++;
+				cache.splice(cache.begin(), cache, found->second);
+				return found->second->data;
+			}
+			if(!vstd::contains(loading, rid))
+				break;
+			//file is being read by another thread, e.g. prefetched one
+			loaded.wait(lock);
 		}
-		// Still here? Cache miss
-		if (cache.size() > cacheSize)
-			cache.pop_front();
+		statistics.misses++;
 
-		auto data =  CResourceHandler::get()->load(rid)->readAll();
+		// Still here? Cache miss, file is loaded without lock
+		loading.insert(rid);
+		lock.unlock();
+		std::pair<std::shared_ptr<const ui8>, si64> data;
+		try
+		{
+			//archives provide data without copying
+			data = CResourceHandler::get()->load(rid)->readShared();
+		}
+		catch(...)
+		{
+			lock.lock();
+			loading.erase(rid);
+			loaded.notify_all();
+			throw;
+		}
+		lock.lock();
+		loading.erase(rid);
+		loaded.notify_all();
 
-		cache.emplace_back(std::move(rid), data.second, std::move(data.first));
+		cache.emplace_front(rid, data.second, std::move(data.first));
+		index[rid] = cache.begin();
+		cachedBytes += data.second;
+		evict();
 
-		return cache.back().getCopy();
+		return cache.front().data;
+	}
+
+	CAnimation::FileCacheStatistics getStatistics() const
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		CAnimation::FileCacheStatistics ret = statistics;
+		ret.files = cache.size();
+		ret.bytes = cachedBytes;
+		return ret;
 	}
 };
 
@@ -195,6 +265,548 @@ enum class DefType : uint32_t
 
 static CFileCache animationCache;
 
+/// All decoded frames of single def file in disk cache: palette-indexed pixels packed one after another,
+/// so they can be mapped into memory and copied to surfaces without decoding.
+/// Data is stored in native byte order, cache files are not meant to be moved between machines.
+class CSpriteAtlas
+{
+public:
+	static const ui32 VERSION = 1; //increase on any change of format or of def decoding
+	static const ui32 MAX_GROUPS = 1024; //defs with groups beyond it are not cached
+
+	struct Header
+	{
+		char magic[8];
+		ui32 version;
+		ui32 fingerprint; //of def file the atlas was made from
+		ui32 frameCount;
+		SDL_Color palette[256];
+	};
+
+	struct Frame
+	{
+		ui32 group;
+		ui32 frame;
+		ui32 width; //of pixel data
+		ui32 height;
+		si32 leftMargin;
+		si32 topMargin;
+		ui32 fullWidth;
+		ui32 fullHeight;
+		ui32 offset; //of pixel data from the beginning of atlas
+	};
+
+private:
+	static const char MAGIC[8];
+
+	std::shared_ptr<boost::interprocess::mapped_region> mapping;
+
+	const ui8 * begin() const
+	{
+		return static_cast<const ui8 *>(mapping->get_address());
+	}
+
+	bool isValid(ui32 expectedFingerprint) const
+	{
+		const size_t size = mapping->get_size();
+		if(size < sizeof(Header))
+			return false;
+
+		const Header & head = header();
+		if(std::memcmp(head.magic, MAGIC, sizeof(MAGIC)) != 0 || head.version != VERSION || head.fingerprint != expectedFingerprint)
+			return false;
+		if(size < sizeof(Header) + head.frameCount * (ui64)sizeof(Frame))
+			return false;
+
+		for(ui32 i = 0; i < head.frameCount; i++)
+		{
+			const Frame & entry = frame(i);
+			if(entry.offset > size || entry.width * (ui64)entry.height > size - entry.offset)
+				return false;
+			//indices are used to size lookup tables, group can't have more frames than whole atlas
+			if(entry.group >= MAX_GROUPS || entry.frame >= head.frameCount)
+				return false;
+		}
+		return true;
+	}
+
+public:
+	CSpriteAtlas(std::shared_ptr<boost::interprocess::mapped_region> mapping_):
+		mapping(std::move(mapping_))
+	{}
+
+	const Header & header() const
+	{
+		return *reinterpret_cast<const Header *>(begin());
+	}
+
+	const Frame & frame(size_t index) const
+	{
+		return reinterpret_cast<const Frame *>(begin() + sizeof(Header))[index];
+	}
+
+	const ui8 * pixels(const Frame & entry) const
+	{
+		return begin() + entry.offset;
+	}
+
+	//maps atlas file, returns nullptr if it is missing, damaged or made from another version of def file
+	static std::shared_ptr<const CSpriteAtlas> open(const boost::filesystem::path & path, ui32 fingerprint)
+	{
+		if(!boost::filesystem::exists(path))
+			return nullptr;
+
+		try
+		{
+			boost::interprocess::file_mapping file(path.string().c_str(), boost::interprocess::read_only);
+			auto atlas = std::make_shared<CSpriteAtlas>(std::make_shared<boost::interprocess::mapped_region>(file, boost::interprocess::read_only));
+
+			if(atlas->isValid(fingerprint))
+				return atlas;
+			logAnim->debug("Sprite cache %s is outdated", path.string());
+		}
+		catch(const boost::interprocess::interprocess_exception & e)
+		{
+			logAnim->warn("Failed to map sprite cache %s: %s", path.string(), e.what());
+		}
+		return nullptr;
+	}
+
+	//decodes all frames of def file and writes them into atlas file
+	static void save(const CDefFile & def, const boost::filesystem::path & path, ui32 fingerprint);
+};
+
+const char CSpriteAtlas::MAGIC[8] = {'V', 'C', 'M', 'I', 'S', 'P', 'R', 'T'};
+
+/// Image loader that stores decoded frame for atlas
+class CAtlasFrameWriter
+{
+	std::vector<ui8> & pixels;
+	size_t lineStart;
+	size_t position;
+	size_t end;
+public:
+	CSpriteAtlas::Frame frame;
+	const SDL_Color * palette;
+
+	CAtlasFrameWriter(std::vector<ui8> & pixels_):
+		pixels(pixels_), lineStart(0), position(0), end(0), frame(), palette(nullptr)
+	{}
+
+	void init(Point SpriteSize, Point Margins, Point FullSize, SDL_Color * pal)
+	{
+		frame.width = SpriteSize.x;
+		frame.height = SpriteSize.y;
+		frame.leftMargin = Margins.x;
+		frame.topMargin = Margins.y;
+		frame.fullWidth = FullSize.x;
+		frame.fullHeight = FullSize.y;
+		frame.offset = static_cast<ui32>(pixels.size());
+		palette = pal;
+
+		lineStart = position = pixels.size();
+		end = pixels.size() + frame.width * frame.height;
+		pixels.resize(end, 0);
+	}
+
+	void Load(size_t size, const ui8 * data)
+	{
+		size = std::min(size, end - position); //damaged def must not spill into next frame
+		std::memcpy(pixels.data() + position, data, size);
+		position += size;
+	}
+
+	void Load(size_t size, ui8 color)
+	{
+		size = std::min(size, end - position);
+		std::memset(pixels.data() + position, color, size);
+		position += size;
+	}
+
+	void EndLine()
+	{
+		lineStart = std::min(lineStart + frame.width, end);
+		position = lineStart;
+	}
+};
+
+void CSpriteAtlas::save(const CDefFile & def, const boost::filesystem::path & path, ui32 fingerprint)
+{
+	Header head = {};
+	std::memcpy(head.magic, MAGIC, sizeof(MAGIC));
+	head.version = VERSION;
+	head.fingerprint = fingerprint;
+
+	std::vector<Frame> frames;
+	std::vector<ui8> pixels;
+
+	for(auto & entry : def.getEntries())
+	{
+		if(entry.first >= MAX_GROUPS)
+			return;
+
+		for(size_t index = 0; index < entry.second; index++)
+		{
+			CAtlasFrameWriter writer(pixels);
+			def.loadFrame(index, entry.first, writer);
+			writer.frame.group = static_cast<ui32>(entry.first);
+			writer.frame.frame = static_cast<ui32>(index);
+			frames.push_back(writer.frame);
+
+			if(writer.palette)
+				std::copy(writer.palette, writer.palette + 256, head.palette);
+		}
+	}
+	head.frameCount = static_cast<ui32>(frames.size());
+
+	const size_t pixelsOffset = sizeof(Header) + frames.size() * sizeof(Frame);
+	if(pixelsOffset + pixels.size() > std::numeric_limits<ui32>::max())
+		return;
+	for(auto & frame : frames)
+		frame.offset += static_cast<ui32>(pixelsOffset);
+
+	//atlas is written under temporary name, so other instances never map incomplete file
+	boost::filesystem::path tempPath = path;
+	tempPath += ".tmp";
+
+	boost::filesystem::create_directories(path.parent_path());
+	{
+		FileStream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char *>(&head), sizeof(head));
+		file.write(reinterpret_cast<const char *>(frames.data()), frames.size() * sizeof(Frame));
+		file.write(reinterpret_cast<const char *>(pixels.data()), pixels.size());
+		if(!file)
+			throw std::runtime_error("Failed to write " + tempPath.string());
+	}
+	boost::filesystem::rename(tempPath, path);
+}
+
+/// Optional disk cache of decoded def files, enabled by video.spriteCache setting
+class CSpriteCache
+{
+	boost::mutex mx;
+	std::map<std::string, std::weak_ptr<const CSpriteAtlas>> atlases; //mapped in this session
+	std::set<std::string> saved; //saved or queued for saving in this session
+
+	static const ui64 diskBudget = 512 * 1024 * 1024; //Max total size of atlases in bytes
+
+	static boost::filesystem::path getDirectory()
+	{
+		return VCMIDirs::get().userCachePath() / "sprites";
+	}
+
+	static boost::filesystem::path getPath(const std::string & name)
+	{
+		return getDirectory() / (name + ".vcache");
+	}
+
+	//removes least recently used atlases above disk budget and leftovers of interrupted saves
+	void prune();
+
+public:
+	static bool isEnabled()
+	{
+		return settings["video"]["spriteCache"].Bool();
+	}
+
+	//fingerprint of def file combined with engine version, so any change of decoding invalidates cache
+	static boost::optional<ui32> getFingerprint(const ResourceID & resource)
+	{
+		auto fileFingerprint = CResourceHandler::get()->getResourceFingerprint(resource);
+		if(!fileFingerprint)
+			return fileFingerprint;
+
+		boost::crc_32_type checksum;
+		checksum.process_bytes(GameConstants::VCMI_VERSION.data(), GameConstants::VCMI_VERSION.size());
+		checksum.process_bytes(&*fileFingerprint, sizeof(ui32));
+		return checksum.checksum();
+	}
+
+	std::shared_ptr<const CSpriteAtlas> open(const std::string & name, ui32 fingerprint)
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+
+		auto atlas = atlases[name].lock();
+		if(atlas && atlas->header().fingerprint == fingerprint)
+			return atlas;
+
+		atlas = CSpriteAtlas::open(getPath(name), fingerprint);
+		atlases[name] = atlas;
+
+		//modification time marks last use, so pruning keeps atlases that are still needed
+		boost::system::error_code error;
+		if(atlas)
+			boost::filesystem::last_write_time(getPath(name), std::time(nullptr), error);
+		return atlas;
+	}
+
+	void save(const std::string & name, std::shared_ptr<const CDefFile> def);
+};
+
+static CSpriteCache spriteCache;
+
+// Single frame decoding (or file reading) task executed on worker thread
+class CDecodeJob
+{
+public:
+	enum class EState
+	{
+		QUEUED, RUNNING, DONE, CANCELLED
+	};
+
+	std::function<std::shared_ptr<IImage>()> task;
+	EState state = EState::QUEUED;
+	std::shared_ptr<IImage> image; //result of task, valid in DONE state
+
+	CDecodeJob(std::function<std::shared_ptr<IImage>()> task_):
+		task(std::move(task_))
+	{}
+};
+
+// Worker threads executing decoding jobs in order of queuing. Owner of job may take it over
+// if it is still queued, so requesting frame never waits longer than decoding it by itself
+class CDecodeQueue
+{
+	std::deque<std::shared_ptr<CDecodeJob>> jobs;
+	std::vector<boost::thread> workers;
+	boost::mutex mx;
+	boost::condition_variable jobQueued;
+	boost::condition_variable jobFinished;
+	bool stopping = false;
+
+	void work()
+	{
+		setThreadName("CDecodeQueue::work");
+		boost::unique_lock<boost::mutex> lock(mx);
+
+		while(true)
+		{
+			jobQueued.wait(lock, [this](){ return stopping || !jobs.empty(); });
+			if(stopping)
+				return;
+
+			auto job = jobs.front();
+			jobs.pop_front();
+			if(job->state != CDecodeJob::EState::QUEUED) //taken over or cancelled by owner
+				continue;
+
+			job->state = CDecodeJob::EState::RUNNING;
+			lock.unlock();
+
+			std::shared_ptr<IImage> image;
+			try
+			{
+				image = job->task();
+			}
+			catch(const std::exception & e)
+			{
+				logAnim->error("Failed to decode frame in background: %s", e.what());
+			}
+
+			lock.lock();
+			job->image = image;
+			job->task = nullptr;
+			job->state = CDecodeJob::EState::DONE;
+			jobFinished.notify_all();
+		}
+	}
+
+public:
+	~CDecodeQueue()
+	{
+		stop();
+	}
+
+	//drops queued jobs and waits for running ones, jobs pushed afterwards are dropped as well
+	void stop()
+	{
+		{
+			boost::unique_lock<boost::mutex> lock(mx);
+			stopping = true;
+			for(auto & job : jobs)
+			{
+				if(job->state == CDecodeJob::EState::QUEUED)
+				{
+					job->state = CDecodeJob::EState::CANCELLED;
+					job->task = nullptr;
+				}
+			}
+			jobs.clear();
+		}
+		jobQueued.notify_all();
+		for(auto & worker : workers)
+			worker.join();
+		workers.clear();
+	}
+
+	void push(std::shared_ptr<CDecodeJob> job)
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+
+		if(stopping)
+		{
+			job->state = CDecodeJob::EState::CANCELLED;
+			job->task = nullptr;
+			return;
+		}
+
+		if(workers.empty())
+		{
+			//one core is left for main thread
+			int count = std::max<int>(1, boost::thread::hardware_concurrency() - 1);
+			for(int i = 0; i < count; i++)
+				workers.push_back(boost::thread(&CDecodeQueue::work, this));
+			logAnim->debug("Started %d frame decoding threads", count);
+		}
+
+		jobs.push_back(std::move(job));
+		jobQueued.notify_one();
+	}
+
+	//returns result of finished job. Queued job is cancelled if wait is set, so caller has to execute it by itself
+	std::shared_ptr<IImage> take(CDecodeJob & job, bool wait)
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+
+		if(job.state == CDecodeJob::EState::QUEUED && wait)
+		{
+			job.state = CDecodeJob::EState::CANCELLED;
+			job.task = nullptr;
+		}
+
+		if(job.state == CDecodeJob::EState::RUNNING && wait)
+			jobFinished.wait(lock, [&job](){ return job.state == CDecodeJob::EState::DONE; });
+
+		if(job.state == CDecodeJob::EState::DONE)
+			return job.image;
+		return nullptr;
+	}
+
+	CDecodeJob::EState getState(const CDecodeJob & job)
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		return job.state;
+	}
+
+	void cancel(CDecodeJob & job)
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+
+		//running job is finished anyway, its result is dropped with job
+		if(job.state == CDecodeJob::EState::QUEUED)
+		{
+			job.state = CDecodeJob::EState::CANCELLED;
+			job.task = nullptr;
+		}
+	}
+};
+
+static CDecodeQueue decodeQueue;
+
+void CSpriteCache::prune()
+{
+	struct Entry
+	{
+		boost::filesystem::path path;
+		std::time_t lastUse;
+		ui64 size;
+	};
+
+	std::set<std::string> inUse;
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		inUse = saved;
+		for(auto & atlas : atlases)
+			if(!atlas.second.expired())
+				inUse.insert(atlas.first);
+	}
+
+	boost::system::error_code error;
+	std::vector<Entry> entries;
+	ui64 totalSize = 0;
+
+	for(boost::filesystem::directory_iterator it(getDirectory(), error), end; !error && it != end; it.increment(error))
+	{
+		const boost::filesystem::path & path = it->path();
+		boost::system::error_code fileError;
+
+		if(path.extension() == ".tmp")
+		{
+			//other instance may be writing it right now
+			if(std::time(nullptr) - boost::filesystem::last_write_time(path, fileError) > 3600 && !fileError)
+				boost::filesystem::remove(path, fileError);
+			continue;
+		}
+		if(path.extension() != ".vcache" || vstd::contains(inUse, path.stem().string()))
+			continue;
+
+		Entry entry = {path, boost::filesystem::last_write_time(path, fileError), 0};
+		entry.size = boost::filesystem::file_size(path, fileError);
+		if(fileError)
+			continue;
+
+		totalSize += entry.size;
+		entries.push_back(entry);
+	}
+
+	if(totalSize <= diskBudget)
+		return;
+
+	boost::range::sort(entries, [](const Entry & a, const Entry & b)
+	{
+		return a.lastUse < b.lastUse;
+	});
+
+	for(auto & entry : entries)
+	{
+		if(totalSize <= diskBudget)
+			break;
+
+		boost::system::error_code fileError;
+		if(boost::filesystem::remove(entry.path, fileError))
+		{
+			totalSize -= entry.size;
+			logAnim->trace("Removed %s from sprite cache", entry.path.string());
+		}
+	}
+}
+
+void CSpriteCache::save(const std::string & name, std::shared_ptr<const CDefFile> def)
+{
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		if(saved.empty())
+		{
+			//once per session, before cache grows with new atlases
+			decodeQueue.push(std::make_shared<CDecodeJob>([=]() -> std::shared_ptr<IImage>
+			{
+				prune();
+				return nullptr;
+			}));
+		}
+		if(!saved.insert(name).second)
+			return;
+	}
+
+	const auto path = getPath(name);
+	const ui32 fingerprint = *def->getFingerprint();
+
+	//decoding all frames takes a while, so it is done by workers together with frame prefetching
+	decodeQueue.push(std::make_shared<CDecodeJob>([=]() -> std::shared_ptr<IImage>
+	{
+		try
+		{
+			CSpriteAtlas::save(*def, path, fingerprint);
+			logAnim->trace("Saved %s into sprite cache", name);
+		}
+		catch(const std::exception & e)
+		{
+			logAnim->warn("Failed to save sprite cache %s: %s", path.string(), e.what());
+		}
+		return nullptr;
+	}));
+}
+
 /*************************************************************************
  *  DefFile, class used for def loading                                  *
  *************************************************************************/
@@ -208,6 +820,18 @@ CDefFile::CDefFile(std::string Name):
 	data(nullptr),
 	palette(nullptr)
 {
+	if(CSpriteCache::isEnabled())
+	{
+		fingerprint = CSpriteCache::getFingerprint(ResourceID(std::string("SPRITES/") + Name, EResType::ANIMATION));
+		if(fingerprint)
+			atlas = spriteCache.open(Name, *fingerprint);
+
+		if(atlas)
+		{
+			initFromAtlas();
+			return;
+		}
+	}
 
 	#if 0
 	static SDL_Color H3_ORIG_PALETTE[8] =
@@ -250,9 +874,9 @@ CDefFile::CDefFile(std::string Name):
 
 	for (ui32 i= 0; i<256; i++)
 	{
-		palette[i].r = data[it++];
-		palette[i].g = data[it++];
-		palette[i].b = data[it++];
+		palette[i].r = data.get()[it++];
+		palette[i].g = data.get()[it++];
+		palette[i].b = data.get()[it++];
 		palette[i].a = SDL_ALPHA_OPAQUE;
 	}
 
@@ -336,6 +960,25 @@ void CDefFile::loadFrame(size_t frame, size_t group, ImageLoader &loader) const
 	it = offset.find(group);
 	assert (it != offset.end());
 
+	if(atlas)
+	{
+		//frame is already decoded, just copy it
+		const CSpriteAtlas::Frame & entry = atlas->frame(it->second[frame]);
+		const ui8 * pixels = atlas->pixels(entry);
+
+		loader.init(Point(entry.width, entry.height),
+					Point(entry.leftMargin, entry.topMargin),
+					Point(entry.fullWidth, entry.fullHeight), palette.get());
+
+		for(ui32 i=0; i<entry.height; i++)
+		{
+			loader.Load(entry.width, pixels);
+			pixels += entry.width;
+			loader.EndLine();
+		}
+		return;
+	}
+
 	const ui8 * FDef = data.get()+it->second[frame];
 
 	const SSpriteDef sd = * reinterpret_cast<const SSpriteDef *>(FDef);
@@ -480,6 +1123,33 @@ void CDefFile::loadFrame(size_t frame, size_t group, ImageLoader &loader) const
 
 CDefFile::~CDefFile() = default;
 
+void CDefFile::initFromAtlas()
+{
+	const CSpriteAtlas::Header & header = atlas->header();
+
+	palette = std::unique_ptr<SDL_Color[]>(new SDL_Color[256]);
+	std::copy(header.palette, header.palette + 256, palette.get());
+
+	for(ui32 i = 0; i < header.frameCount; i++)
+	{
+		const CSpriteAtlas::Frame & entry = atlas->frame(i);
+		auto & frames = offset[entry.group];
+		if(frames.size() <= entry.frame)
+			frames.resize(entry.frame + 1);
+		frames[entry.frame] = i;
+	}
+}
+
+bool CDefFile::shouldBeCached() const
+{
+	return fingerprint && !atlas;
+}
+
+boost::optional<ui32> CDefFile::getFingerprint() const
+{
+	return fingerprint;
+}
+
 const std::map<size_t, size_t > CDefFile::getEntries() const
 {
 	std::map<size_t, size_t > ret;
@@ -855,7 +1525,7 @@ std::shared_ptr<IImage> CAnimation::getFromExtraDef(std::string filename)
 	return ret;
 }
 
-bool CAnimation::loadFrame(size_t frame, size_t group)
+bool CAnimation::loadFrame(size_t frame, size_t group, bool waitForPending)
 {
 	if(size(group) <= frame)
 	{
@@ -869,6 +1539,16 @@ bool CAnimation::loadFrame(size_t frame, size_t group)
 		return true;
 	}
 
+	if(!waitForPending && vstd::contains(pending[group], frame) && decodeQueue.getState(*pending[group][frame]) == CDecodeJob::EState::RUNNING)
+		return false;
+
+	image = takePending(frame, group, true);
+	if(image)
+	{
+		images[group][frame] = image;
+		return true;
+	}
+
 	//try to get image from def
 	if(source[group][frame].getType() == JsonNode::JsonType::DATA_NULL)
 	{
@@ -899,8 +1579,48 @@ bool CAnimation::loadFrame(size_t frame, size_t group)
 	return false;
 }
 
+std::shared_ptr<IImage> CAnimation::takePending(size_t frame, size_t group, bool wait)
+{
+	auto groupIter = pending.find(group);
+	if(groupIter == pending.end())
+		return nullptr;
+
+	auto jobIter = groupIter->second.find(frame);
+	if(jobIter == groupIter->second.end())
+		return nullptr;
+
+	auto job = jobIter->second;
+	auto image = decodeQueue.take(*job, wait);
+
+	if(wait || image)
+	{
+		groupIter->second.erase(jobIter);
+		if(groupIter->second.empty())
+			pending.erase(groupIter);
+	}
+	return image;
+}
+
+void CAnimation::cancelPending(size_t frame, size_t group)
+{
+	auto groupIter = pending.find(group);
+	if(groupIter == pending.end())
+		return;
+
+	auto jobIter = groupIter->second.find(frame);
+	if(jobIter == groupIter->second.end())
+		return;
+
+	decodeQueue.cancel(*jobIter->second);
+	groupIter->second.erase(jobIter);
+	if(groupIter->second.empty())
+		pending.erase(groupIter);
+}
+
 bool CAnimation::unloadFrame(size_t frame, size_t group)
 {
+	cancelPending(frame, group);
+
 	auto image = getImage(frame, group, false);
 	if(image)
 	{
@@ -1032,7 +1752,11 @@ CAnimation::CAnimation(std::string Name):
 	ResourceID resource(std::string("SPRITES/") + name, EResType::ANIMATION);
 
 	if(CResourceHandler::get()->existsResource(resource))
+	{
 		defFile = std::make_shared<CDefFile>(name);
+		if(defFile->shouldBeCached())
+			spriteCache.save(name, defFile);
+	}
 
 	init();
 
@@ -1048,7 +1772,12 @@ CAnimation::CAnimation():
 	init();
 }
 
-CAnimation::~CAnimation() = default;
+CAnimation::~CAnimation()
+{
+	for(auto & group : pending)
+		for(auto & job : group.second)
+			decodeQueue.cancel(*job.second);
+}
 
 void CAnimation::duplicateImage(const size_t sourceGroup, const size_t sourceFrame, const size_t targetGroup)
 {
@@ -1115,8 +1844,51 @@ std::shared_ptr<IImage> CAnimation::getImage(size_t frame, size_t group, bool ve
 	return nullptr;
 }
 
+std::shared_ptr<IImage> CAnimation::getImageOrPlaceholder(size_t frame, size_t group, std::shared_ptr<IImage> placeholder)
+{
+	if(auto image = getImage(frame, group, false))
+		return image;
+
+	if(size(group) <= frame)
+	{
+		printError(frame, group, "GetImage");
+		return placeholder;
+	}
+
+	if(!vstd::contains(pending[group], frame))
+	{
+		prefetchGroup(group);
+		//frame from other file or missing in def file
+		if(!vstd::contains(pending[group], frame))
+		{
+			loadFrame(frame, group);
+			return getImage(frame, group, false);
+		}
+	}
+
+	auto job = pending[group][frame];
+	if(auto image = takePending(frame, group, false))
+	{
+		images[group][frame] = image;
+		return image;
+	}
+
+	//decoding failed on worker thread, try again with error reporting of loadFrame
+	if(decodeQueue.getState(*job) == CDecodeJob::EState::DONE)
+	{
+		loadFrame(frame, group);
+		return getImage(frame, group, false);
+	}
+	return placeholder;
+}
+
 void CAnimation::load()
 {
+	//frames that are already being decoded by workers are taken after the rest
+	for (auto & elem : source)
+		for (size_t image=0; image < elem.second.size(); image++)
+			loadFrame(image, elem.first, false);
+
 	for (auto & elem : source)
 		for (size_t image=0; image < elem.second.size(); image++)
 			loadFrame(image, elem.first);
@@ -1135,15 +1907,52 @@ void CAnimation::preload()
 	if(!preloaded)
 	{
 		preloaded = true;
+		prefetch();
 		load();
 	}
 }
 
+void CAnimation::prefetch()
+{
+	for(auto & elem : source)
+		prefetchGroup(elem.first);
+}
+
+void CAnimation::prefetchGroup(size_t group)
+{
+	if(!defFile || !vstd::contains(source, group))
+		return;
+
+	auto frameList = defFile->getEntries();
+	if(!vstd::contains(frameList, group))
+		return;
+
+	for(size_t frame = 0; frame < source[group].size() && frame < frameList.at(group); frame++)
+	{
+		if(source[group][frame].getType() != JsonNode::JsonType::DATA_NULL)
+			continue; //frame from separate file
+		if(getImage(frame, group, false) || vstd::contains(pending[group], frame))
+			continue;
+
+		auto file = defFile;
+		auto job = std::make_shared<CDecodeJob>([=]() -> std::shared_ptr<IImage>
+		{
+			return std::make_shared<SDLImage>(file.get(), frame, group);
+		});
+		pending[group][frame] = job;
+		decodeQueue.push(job);
+	}
+}
+
 void CAnimation::loadGroup(size_t group)
 {
 	if (vstd::contains(source, group))
+	{
+		for (size_t image=0; image < source[group].size(); image++)
+			loadFrame(image, group, false);
 		for (size_t image=0; image < source[group].size(); image++)
 			loadFrame(image, group);
+	}
 }
 
 void CAnimation::unloadGroup(size_t group)
@@ -1171,6 +1980,42 @@ size_t CAnimation::size(size_t group) const
 	return 0;
 }
 
+CAnimation::FileCacheStatistics CAnimation::getFileCacheStatistics()
+{
+	return animationCache.getStatistics();
+}
+
+void CAnimation::prefetchFiles(const std::vector<std::string> & names)
+{
+	std::set<std::string> queued;
+
+	for(std::string name : names)
+	{
+		size_t dotPos = name.find_last_of('.');
+		if(dotPos != std::string::npos)
+			name.erase(dotPos);
+		boost::to_upper(name);
+
+		if(!queued.insert(name).second)
+			continue;
+
+		ResourceID resource(std::string("SPRITES/") + name, EResType::ANIMATION);
+		if(!CResourceHandler::get()->existsResource(resource))
+			continue;
+
+		decodeQueue.push(std::make_shared<CDecodeJob>([=]() -> std::shared_ptr<IImage>
+		{
+			animationCache.getCachedFile(resource);
+			return nullptr;
+		}));
+	}
+}
+
+void CAnimation::stopDecoding()
+{
+	decodeQueue.stop();
+}
+
 void CAnimation::horizontalFlip()
 {
 	for(auto & group : images)
@@ -24,6 +24,7 @@
 struct SDL_Surface;
 class JsonNode;
 class CDefFile;
+class CDecodeJob;
 class ColorShifter;
 
 /*
@@ -83,8 +84,16 @@ private:
 
 	std::shared_ptr<CDefFile> defFile;
 
+	//pending[group][position], frames queued for decoding on worker threads, moved to images once taken
+	std::map<size_t, std::map<size_t, std::shared_ptr<CDecodeJob> > > pending;
+
 	//loader, will be called by load(), require opened def file for loading from it. Returns true if image is loaded
-	bool loadFrame(size_t frame, size_t group);
+	//if waitForPending is false, frame being decoded by worker thread is skipped
+	bool loadFrame(size_t frame, size_t group, bool waitForPending = true);
+
+	//result of frame queued for decoding, nullptr if frame was not queued or has to be decoded by caller
+	std::shared_ptr<IImage> takePending(size_t frame, size_t group, bool wait);
+	void cancelPending(size_t frame, size_t group);
 
 	//unloadFrame, returns true if image has been unloaded ( either deleted or decreased refCount)
 	bool unloadFrame(size_t frame, size_t group);
@@ -101,6 +110,16 @@ private:
 	std::shared_ptr<IImage> getFromExtraDef(std::string filename);
 
 public:
+	/// Statistics of cache with raw def files shared by all animations
+	struct FileCacheStatistics
+	{
+		ui64 hits;
+		ui64 misses;
+		ui64 evictions;
+		size_t files; //currently cached
+		size_t bytes;
+	};
+
 	CAnimation(std::string Name);
 	CAnimation();
 	~CAnimation();
@@ -117,6 +136,10 @@ public:
 
 	std::shared_ptr<IImage> getImage(size_t frame, size_t group=0, bool verbose=true) const;
 
+	//non-blocking version of getImage: returns image if it is loaded or already decoded by worker thread,
+	//otherwise queues its decoding and returns placeholder
+	std::shared_ptr<IImage> getImageOrPlaceholder(size_t frame, size_t group, std::shared_ptr<IImage> placeholder);
+
 	void exportBitmaps(const boost::filesystem::path & path) const;
 
 	//all available frames
@@ -124,6 +147,10 @@ public:
 	void unload();
 	void preload();
 
+	//queue decoding of frames that are not loaded on worker threads, load() takes finished ones
+	void prefetch();
+	void prefetchGroup(size_t group);
+
 	//all frames from group
 	void loadGroup  (size_t group);
 	void unloadGroup(size_t group);
@@ -139,6 +166,14 @@ public:
 	void verticalFlip();
 	void playerColored(PlayerColor player);
 
+	static FileCacheStatistics getFileCacheStatistics();
+
+	//read def files of animations that will be created soon into file cache on worker threads
+	static void prefetchFiles(const std::vector<std::string> & names);
+
+	//stop worker threads, must be called before shutdown of engine. Frames are decoded on calling thread afterwards
+	static void stopDecoding();
+
 	void createFlippedGroup(const size_t sourceGroup, const size_t targetGroup);
 };
 
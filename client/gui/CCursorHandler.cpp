@@ -216,6 +216,10 @@ void CCursorHandler::centerCursor()
 
 void CCursorHandler::render()
 {
+	renderedShowing = showing;
+	renderedX = xpos;
+	renderedY = ypos;
+
 	if(!showing)
 		return;
 
@@ -241,6 +245,14 @@ void CCursorHandler::render()
 	SDL_RenderCopy(mainRenderer, cursorLayer, nullptr, &destRect);
 }
 
+bool CCursorHandler::needsRender() const
+{
+	if(showing != renderedShowing)
+		return true;
+
+	return showing && (needUpdate || xpos != renderedX || ypos != renderedY);
+}
+
 void CCursorHandler::updateTexture()
 {
 	if(needUpdate)
@@ -254,7 +266,10 @@ CCursorHandler::CCursorHandler()
 	: needUpdate(true),
 	buffer(nullptr),
 	cursorLayer(nullptr),
-	showing(false)
+	showing(false),
+	renderedShowing(false),
+	renderedX(0),
+	renderedY(0)
 {
 
 }
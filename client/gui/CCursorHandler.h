@@ -39,6 +39,10 @@ class CCursorHandler final
 
 	bool showing;
 
+	/// state of cursor on last render
+	bool renderedShowing;
+	int renderedX, renderedY;
+
 	void clearBuffer();
 	void updateBuffer(CIntObject * payload);
 	void replaceBuffer(CIntObject * payload);
@@ -68,6 +72,8 @@ public:
 	void dragAndDropCursor (std::unique_ptr<CAnimImage> image);
 
 	void render();
+	/// true if cursor was changed, moved, shown or hidden since last render
+	bool needsRender() const;
 
 	void hide() { showing=false; };
 	void show() { showing=true; };
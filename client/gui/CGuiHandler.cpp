@@ -464,13 +464,21 @@ void CGuiHandler::renderFrame()
 		if(settings["general"]["showfps"].Bool())
 			drawFPSCounter();
 
-		SDL_UpdateTexture(screenTexture, nullptr, screen->pixels, screen->pitch);
+		// only changed parts of screen are uploaded, idle frames are not presented at all
+		if(findDirtyRects() || CCS->curh->needsRender())
+		{
+			for(auto & rect : dirtyRects)
+			{
+				auto pixels = static_cast<const ui8 *>(screen->pixels) + rect.y * screen->pitch + rect.x * screen->format->BytesPerPixel;
+				SDL_UpdateTexture(screenTexture, &rect, pixels, screen->pitch);
+			}
 
-		SDL_RenderCopy(mainRenderer, screenTexture, nullptr, nullptr);
+			SDL_RenderCopy(mainRenderer, screenTexture, nullptr, nullptr);
 
-		CCS->curh->render();
+			CCS->curh->render();
 
-		SDL_RenderPresent(mainRenderer);
+			SDL_RenderPresent(mainRenderer);
+		}
 
 		disposed.clear();
 	}
@@ -478,11 +486,99 @@ void CGuiHandler::renderFrame()
 	mainFPSmng->framerateDelay(); // holds a constant FPS
 }
 
+void CGuiHandler::invalidateScreen()
+{
+	screenInvalidated = true;
+}
+
+bool CGuiHandler::findDirtyRects()
+{
+	// screen is compared in blocks, changed blocks next to each other are uploaded as single rect
+	// comparison is done on every frame, so show() of any widget may change what it draws without notifying anyone
+	// (about 0.7 ms per frame at 1920x1080)
+	static const int BLOCK_WIDTH = 64;
+	static const int BLOCK_HEIGHT = 16;
+
+	const auto pixels = static_cast<const ui8 *>(screen->pixels);
+	const size_t screenSize = screen->pitch * screen->h;
+	const int bpp = screen->format->BytesPerPixel;
+
+	dirtyRects.clear();
+	dirtyArea = 0;
+
+	if(screenInvalidated || presentedScreen.size() != screenSize)
+	{
+		presentedScreen.assign(pixels, pixels + screenSize);
+		dirtyRects.push_back(Rect(0, 0, screen->w, screen->h));
+		dirtyArea = screen->w * screen->h;
+		screenInvalidated = false;
+		return true;
+	}
+
+	auto addDirtyRect = [&](const Rect & rect)
+	{
+		dirtyArea += rect.w * rect.h;
+
+		// extend rect from previous band if it covers same columns
+		for(auto & dirty : dirtyRects)
+		{
+			if(dirty.x == rect.x && dirty.w == rect.w && dirty.y + dirty.h == rect.y)
+			{
+				dirty.h += rect.h;
+				return;
+			}
+		}
+		dirtyRects.push_back(rect);
+	};
+
+	for(int blockY = 0; blockY < screen->h; blockY += BLOCK_HEIGHT)
+	{
+		const int blockH = std::min(BLOCK_HEIGHT, screen->h - blockY);
+		Rect run(0, blockY, 0, blockH);
+
+		for(int blockX = 0; blockX < screen->w; blockX += BLOCK_WIDTH)
+		{
+			const int blockW = std::min(BLOCK_WIDTH, screen->w - blockX);
+			bool changed = false;
+
+			for(int y = blockY; y < blockY + blockH; y++)
+			{
+				const size_t offset = y * screen->pitch + blockX * bpp;
+				if(changed || std::memcmp(pixels + offset, presentedScreen.data() + offset, blockW * bpp) != 0)
+				{
+					// rows above are unchanged, only this and following ones need to be copied
+					std::memcpy(presentedScreen.data() + offset, pixels + offset, blockW * bpp);
+					changed = true;
+				}
+			}
+
+			if(changed)
+			{
+				if(run.w == 0)
+					run.x = blockX;
+				run.w += blockW;
+			}
+			else if(run.w != 0)
+			{
+				addDirtyRect(run);
+				run.w = 0;
+			}
+		}
+
+		if(run.w != 0)
+			addDirtyRect(run);
+	}
+
+	return !dirtyRects.empty();
+}
+
 
 CGuiHandler::CGuiHandler()
 	: lastClick(-500, -500),lastClickTime(0), defActionsDef(0), captureChildren(false)
 {
 	continueEventHandling = true;
+	dirtyArea = 0;
+	screenInvalidated = true;
 	curInt = nullptr;
 	current = nullptr;
 	statusbar = nullptr;
@@ -508,11 +604,14 @@ void CGuiHandler::breakEventHandling()
 void CGuiHandler::drawFPSCounter()
 {
 	const static SDL_Color yellow = {255, 255, 0, 0};
-	static SDL_Rect overlay = { 0, 0, 64, 32};
+	static SDL_Rect overlay = { 0, 0, 64, 48};
 	Uint32 black = SDL_MapRGB(screen->format, 10, 10, 10);
 	SDL_FillRect(screen, &overlay, black);
 	std::string fps = boost::lexical_cast<std::string>(mainFPSmng->fps);
 	graphics->fonts[FONT_BIG]->renderTextLeft(screen, fps, yellow, Point(10, 10));
+	// part of screen updated on previous frame
+	std::string dirty = boost::lexical_cast<std::string>(100 * dirtyArea / std::max(1, screen->w * screen->h)) + "%";
+	graphics->fonts[FONT_SMALL]->renderTextLeft(screen, dirty, yellow, Point(10, 30));
 }
 
 SDL_Keycode CGuiHandler::arrowToNum(SDL_Keycode key)
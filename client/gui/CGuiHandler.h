@@ -80,6 +80,17 @@ private:
 	               textInterested;
 
 
+	/// copy of screen contents as they were uploaded to screen texture
+	std::vector<ui8> presentedScreen;
+	/// parts of screen that changed since previous frame
+	std::vector<Rect> dirtyRects;
+	/// total area of dirtyRects in previous frame [in pixels]
+	int dirtyArea;
+	bool screenInvalidated;
+
+	/// compares screen with presented copy and fills dirtyRects, @returns false if nothing has changed
+	bool findDirtyRects();
+
 	void handleMouseButtonClick(CIntObjectList & interestedObjs, EIntObjMouseBtnType btn, bool isPressed);
 	void processLists(const ui16 activityFlag, std::function<void (std::list<CIntObject*> *)> cb);
 public:
@@ -104,6 +115,8 @@ public:
 	~CGuiHandler();
 
 	void renderFrame();
+	/// forces upload and presentation of whole screen on next frame, e.g. after renderer was used directly
+	void invalidateScreen();
 
 	void totalRedraw(); //forces total redraw (using showAll), sets a flag, method gets called at the end of the rendering
 	void simpleRedraw(); //update only top interface and draw background from buffer, sets a flag, method gets called at the end of the rendering
@@ -129,7 +142,7 @@ public:
 	void handleMoveInterested( const SDL_MouseMotionEvent & motion );
 	void fakeMouseMove();
 	void breakEventHandling(); //current event won't be propagated anymore
-	void drawFPSCounter(); // draws the FPS to the upper left corner of the screen
+	void drawFPSCounter(); // draws the FPS and updated part of the screen to the upper left corner of the screen
 
 	static SDL_Keycode arrowToNum(SDL_Keycode key); //converts arrow key to according numpad key
 	static SDL_Keycode numToDigit(SDL_Keycode key);//converts numpad digit key to normal digit key
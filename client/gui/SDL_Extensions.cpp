@@ -10,6 +10,7 @@
 #include "StdInc.h"
 #include "SDL_Extensions.h"
 #include "SDL_Pixels.h"
+#include "SDL_PaletteBlit.h"
 
 #include "../CGameInfo.h"
 #include "../CMessage.h"
@@ -303,6 +304,16 @@ int CSDL_Ext::blit8bppAlphaTo24bppT(const SDL_Surface * src, const SDL_Rect * sr
 			Uint8 *colory = (Uint8*)src->pixels + srcy*src->pitch + srcx;
 			Uint8 *py = (Uint8*)dst->pixels + dstRect->y*dst->pitch + dstRect->x*bpp;
 
+			if(bpp == 4) //vectorized version, if CPU supports it
+			{
+				const auto blitRow = PaletteBlit::getRowBlitter();
+				for(int y=h; y; y--, colory+=src->pitch, py+=dst->pitch)
+					blitRow(colory, py, w, colors);
+
+				SDL_UnlockSurface(dst);
+				return 0;
+			}
+
 			for(int y=h; y; y--, colory+=src->pitch, py+=dst->pitch)
 			{
 				Uint8 *color = colory;
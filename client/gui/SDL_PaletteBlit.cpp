@@ -0,0 +1,250 @@
+/*
+ * SDL_PaletteBlit.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "SDL_PaletteBlit.h"
+#include "SDL_Pixels.h"
+
+#ifdef VCMI_PALETTE_BLIT_X86
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define VCMI_TARGET(features)
+	#else
+		#define VCMI_TARGET(features) __attribute__((target(features)))
+	#endif
+#endif
+
+void PaletteBlit::blitRowScalar(const ui8 * src, ui8 * dst, int width, const SDL_Color * palette)
+{
+	for(int x = 0; x < width; x++)
+	{
+		const SDL_Color & color = palette[src[x]];
+		ColorPutter<4, +1>::PutColorAlphaSwitch(dst, color.r, color.g, color.b, color.a);
+	}
+}
+
+#ifdef VCMI_PALETTE_BLIT_X86
+
+// Vector kernels work on palette entries loaded as 32-bit words (r, g, b, a in memory order)
+// and on destination pixels in little-endian BGRA order used by Channels::px<4>.
+//
+// Blending uses weight w = alpha, or 256 for opaque pixels: (src * w + dst * (256 - w)) >> 8
+// This is equal to dst + ((src - dst) * alpha >> 8) used by ColorPutter, gives exact average for alpha 128,
+// copies source for opaque and keeps destination for transparent pixels. Largest possible sum is 255 * 256,
+// so it fits into 16-bit lanes. Alpha channel of every non-transparent pixel is set to 255.
+
+static STRONG_INLINE ui32 loadColor(const SDL_Color * palette, ui8 index)
+{
+	ui32 ret;
+	std::memcpy(&ret, palette + index, sizeof(ret));
+	return ret;
+}
+
+VCMI_TARGET("sse2")
+static STRONG_INLINE __m128i toDestinationOrder(__m128i color)
+{
+	// swap r and b channels
+	const __m128i greenAlpha = _mm_set1_epi32(0xFF00FF00);
+	const __m128i low = _mm_set1_epi32(0x000000FF);
+
+	__m128i ret = _mm_and_si128(color, greenAlpha);
+	ret = _mm_or_si128(ret, _mm_slli_epi32(_mm_and_si128(color, low), 16));
+	ret = _mm_or_si128(ret, _mm_and_si128(_mm_srli_epi32(color, 16), low));
+	return ret;
+}
+
+VCMI_TARGET("sse2")
+static STRONG_INLINE __m128i blendHalf(__m128i source, __m128i target, __m128i weight)
+{
+	const __m128i full = _mm_set1_epi16(256);
+	__m128i sum = _mm_add_epi16(_mm_mullo_epi16(source, weight), _mm_mullo_epi16(target, _mm_sub_epi16(full, weight)));
+	return _mm_srli_epi16(sum, 8);
+}
+
+VCMI_TARGET("sse2")
+void PaletteBlit::blitRowSSE2(const ui8 * src, ui8 * dst, int width, const SDL_Color * palette)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i opaque = _mm_set1_epi32(255);
+	const __m128i alphaChannel = _mm_set1_epi32(0xFF000000);
+
+	int x = 0;
+	for(; x + 4 <= width; x += 4)
+	{
+		__m128i color = _mm_set_epi32(loadColor(palette, src[x + 3]), loadColor(palette, src[x + 2]), loadColor(palette, src[x + 1]), loadColor(palette, src[x]));
+		__m128i alpha = _mm_srli_epi32(color, 24);
+		__m128i isTransparent = _mm_cmpeq_epi32(alpha, zero);
+		__m128i isOpaque = _mm_cmpeq_epi32(alpha, opaque);
+
+		if(_mm_movemask_epi8(isTransparent) == 0xFFFF)
+			continue;
+
+		auto target = reinterpret_cast<__m128i *>(dst + x * 4);
+		color = _mm_or_si128(toDestinationOrder(color), alphaChannel);
+
+		if(_mm_movemask_epi8(isOpaque) == 0xFFFF)
+		{
+			_mm_storeu_si128(target, color);
+			continue;
+		}
+
+		// weight of each pixel repeated in all four 16-bit channels
+		__m128i weight = _mm_sub_epi32(alpha, isOpaque);
+		weight = _mm_or_si128(weight, _mm_slli_epi32(weight, 16));
+
+		__m128i current = _mm_loadu_si128(target);
+		__m128i low = blendHalf(_mm_unpacklo_epi8(color, zero), _mm_unpacklo_epi8(current, zero), _mm_unpacklo_epi32(weight, weight));
+		__m128i high = blendHalf(_mm_unpackhi_epi8(color, zero), _mm_unpackhi_epi8(current, zero), _mm_unpackhi_epi32(weight, weight));
+		__m128i result = _mm_packus_epi16(low, high);
+
+		result = _mm_or_si128(result, _mm_andnot_si128(isTransparent, alphaChannel));
+		_mm_storeu_si128(target, result);
+	}
+
+	blitRowScalar(src + x, dst + x * 4, width - x, palette);
+}
+
+VCMI_TARGET("avx2")
+static STRONG_INLINE __m256i blendHalf(__m256i source, __m256i target, __m256i weight)
+{
+	const __m256i full = _mm256_set1_epi16(256);
+	__m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(source, weight), _mm256_mullo_epi16(target, _mm256_sub_epi16(full, weight)));
+	return _mm256_srli_epi16(sum, 8);
+}
+
+VCMI_TARGET("avx2")
+void PaletteBlit::blitRowAVX2(const ui8 * src, ui8 * dst, int width, const SDL_Color * palette)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i opaque = _mm256_set1_epi32(255);
+	const __m256i alphaChannel = _mm256_set1_epi32(0xFF000000);
+	const __m256i greenAlpha = _mm256_set1_epi32(0xFF00FF00);
+	const __m256i lowByte = _mm256_set1_epi32(0x000000FF);
+	const auto colors = reinterpret_cast<const int *>(palette);
+
+	int x = 0;
+	for(; x + 8 <= width; x += 8)
+	{
+		__m256i indexes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + x)));
+		__m256i color = _mm256_i32gather_epi32(colors, indexes, 4);
+		__m256i alpha = _mm256_srli_epi32(color, 24);
+		__m256i isTransparent = _mm256_cmpeq_epi32(alpha, zero);
+		__m256i isOpaque = _mm256_cmpeq_epi32(alpha, opaque);
+
+		if(_mm256_movemask_epi8(isTransparent) == -1)
+			continue;
+
+		auto target = reinterpret_cast<__m256i *>(dst + x * 4);
+
+		// swap r and b channels
+		__m256i ordered = _mm256_and_si256(color, greenAlpha);
+		ordered = _mm256_or_si256(ordered, _mm256_slli_epi32(_mm256_and_si256(color, lowByte), 16));
+		ordered = _mm256_or_si256(ordered, _mm256_and_si256(_mm256_srli_epi32(color, 16), lowByte));
+		color = _mm256_or_si256(ordered, alphaChannel);
+
+		if(_mm256_movemask_epi8(isOpaque) == -1)
+		{
+			_mm256_storeu_si256(target, color);
+			continue;
+		}
+
+		__m256i weight = _mm256_sub_epi32(alpha, isOpaque);
+		weight = _mm256_or_si256(weight, _mm256_slli_epi32(weight, 16));
+
+		__m256i current = _mm256_loadu_si256(target);
+		__m256i low = blendHalf(_mm256_unpacklo_epi8(color, zero), _mm256_unpacklo_epi8(current, zero), _mm256_unpacklo_epi32(weight, weight));
+		__m256i high = blendHalf(_mm256_unpackhi_epi8(color, zero), _mm256_unpackhi_epi8(current, zero), _mm256_unpackhi_epi32(weight, weight));
+		__m256i result = _mm256_packus_epi16(low, high);
+
+		result = _mm256_or_si256(result, _mm256_andnot_si256(isTransparent, alphaChannel));
+		_mm256_storeu_si256(target, result);
+	}
+
+	blitRowSSE2(src + x, dst + x * 4, width - x, palette);
+}
+
+static bool cpuSupportsAVX2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if(info[0] < 7)
+		return false;
+
+	__cpuid(info, 1);
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	if(!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) // OS has to save ymm registers
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static bool cpuSupportsSSE2()
+{
+#if defined(_M_X64) || defined(__x86_64__)
+	return true;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+#else
+	return __builtin_cpu_supports("sse2");
+#endif
+}
+
+#endif // VCMI_PALETTE_BLIT_X86
+
+namespace
+{
+	struct RowBlitterChoice
+	{
+		PaletteBlit::TRowBlitter blitter;
+		const char * name;
+
+		RowBlitterChoice()
+			: blitter(&PaletteBlit::blitRowScalar), name("scalar")
+		{
+#ifdef VCMI_PALETTE_BLIT_X86
+			if(cpuSupportsAVX2())
+			{
+				blitter = &PaletteBlit::blitRowAVX2;
+				name = "AVX2";
+			}
+			else if(cpuSupportsSSE2())
+			{
+				blitter = &PaletteBlit::blitRowSSE2;
+				name = "SSE2";
+			}
+#endif
+			logGlobal->info("Using %s palette blitter", name);
+		}
+	};
+
+	const RowBlitterChoice & rowBlitterChoice()
+	{
+		static const RowBlitterChoice choice;
+		return choice;
+	}
+}
+
+PaletteBlit::TRowBlitter PaletteBlit::getRowBlitter()
+{
+	return rowBlitterChoice().blitter;
+}
+
+const char * PaletteBlit::getRowBlitterName()
+{
+	return rowBlitterChoice().name;
+}
@@ -0,0 +1,35 @@
+/*
+ * SDL_PaletteBlit.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+struct SDL_Color;
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+	#define VCMI_PALETTE_BLIT_X86
+#endif
+
+/// Row kernels for blitting 8 bpp paletted pixels with palette alpha onto 32 bpp surface.
+/// All of them give exactly the same result as ColorPutter<4, 1>::PutColorAlphaSwitch:
+/// transparent pixels are skipped, opaque ones are copied and anything else is blended with destination.
+namespace PaletteBlit
+{
+	typedef void (*TRowBlitter)(const ui8 * src, ui8 * dst, int width, const SDL_Color * palette);
+
+	void blitRowScalar(const ui8 * src, ui8 * dst, int width, const SDL_Color * palette);
+#ifdef VCMI_PALETTE_BLIT_X86
+	void blitRowSSE2(const ui8 * src, ui8 * dst, int width, const SDL_Color * palette);
+	void blitRowAVX2(const ui8 * src, ui8 * dst, int width, const SDL_Color * palette);
+#endif
+
+	/// fastest kernel supported by current CPU, chosen on first call
+	TRowBlitter getRowBlitter();
+	/// name of kernel returned by getRowBlitter, for logging
+	const char * getRowBlitterName();
+}
@@ -33,8 +33,11 @@
 #include "../../lib/NetPacksLobby.h"
 #include "../../lib/CGeneralTextHandler.h"
 #include "../../lib/CModHandler.h"
+#include "../../lib/CThreadHelper.h"
+#include "../../lib/VCMIDirs.h"
 #include "../../lib/filesystem/Filesystem.h"
 #include "../../lib/mapping/CMapInfo.h"
+#include "../../lib/mapping/CMapHeaderCache.h"
 #include "../../lib/serializer/Connection.h"
 
 
@@ -505,38 +508,78 @@ void SelectionTab::restoreLastSelection()
 	}
 }
 
+static void runTasks(std::vector<CThreadHelper::Task> & tasks)
+{
+	//files are independent, each one is parsed by separate task
+	CThreadHelper helper(&tasks, std::max<int>(1, boost::thread::hardware_concurrency()));
+	helper.run();
+}
+
 void SelectionTab::parseMaps(const std::unordered_set<ResourceID> & files)
 {
 	logGlobal->debug("Parsing %d maps", files.size());
-	allItems.clear();
+
+	CMapHeaderCache cache(VCMIDirs::get().userCachePath() / "mapHeaders.vcache");
+	std::vector<std::shared_ptr<CMapInfo>> parsed(files.size());
+	std::vector<CThreadHelper::Task> tasks;
 	for(auto & file : files)
 	{
-		try
+		auto & result = parsed[tasks.size()];
+		tasks.push_back([&file, &result, &cache]()
 		{
-			auto mapInfo = std::make_shared<CMapInfo>();
-			mapInfo->mapInit(file.getName());
+			try
+			{
+				auto mapInfo = std::make_shared<CMapInfo>();
+				mapInfo->mapInit(file.getName(), &cache);
+				result = mapInfo;
+			}
+			catch(std::exception & e)
+			{
+				logGlobal->error("Map %s is invalid. Message: %s", file.getName(), e.what());
+			}
+		});
+	}
+	runTasks(tasks);
+	cache.save();
 
-			// ignore unsupported map versions (e.g. WoG maps without WoG)
-			// but accept VCMI maps
-			if((mapInfo->mapHeader->version >= EMapFormat::VCMI) || (mapInfo->mapHeader->version <= CGI->modh->settings.data["textData"]["mapVersion"].Float()))
-				allItems.push_back(mapInfo);
-		}
-		catch(std::exception & e)
-		{
-			logGlobal->error("Map %s is invalid. Message: %s", file.getName(), e.what());
-		}
+	allItems.clear();
+	for(auto & mapInfo : parsed)
+	{
+		// ignore unsupported map versions (e.g. WoG maps without WoG)
+		// but accept VCMI maps
+		if(mapInfo && ((mapInfo->mapHeader->version >= EMapFormat::VCMI) || (mapInfo->mapHeader->version <= CGI->modh->settings.data["textData"]["mapVersion"].Float())))
+			allItems.push_back(mapInfo);
 	}
+	logGlobal->debug("%d map headers taken from cache", cache.getHits());
 }
 
 void SelectionTab::parseSaves(const std::unordered_set<ResourceID> & files)
 {
+	std::vector<std::shared_ptr<CMapInfo>> parsed(files.size());
+	std::vector<CThreadHelper::Task> tasks;
 	for(auto & file : files)
 	{
-		try
+		auto & result = parsed[tasks.size()];
+		tasks.push_back([&file, &result]()
 		{
-			auto mapInfo = std::make_shared<CMapInfo>();
-			mapInfo->saveInit(file);
+			try
+			{
+				auto mapInfo = std::make_shared<CMapInfo>();
+				mapInfo->saveInit(file);
+				result = mapInfo;
+			}
+			catch(const std::exception & e)
+			{
+				logGlobal->error("Error: Failed to process %s: %s", file.getName(), e.what());
+			}
+		});
+	}
+	runTasks(tasks);
 
+	for(auto & mapInfo : parsed)
+	{
+		if(mapInfo)
+		{
 			// Filter out other game modes
 			bool isCampaign = mapInfo->scenarioOptionsOfSave->mode == StartInfo::CAMPAIGN;
 			bool isMultiplayer = mapInfo->amountOfHumanPlayersInSave > 1;
@@ -558,10 +601,6 @@ void SelectionTab::parseSaves(const std::unordered_set<ResourceID> & files)
 
 			allItems.push_back(mapInfo);
 		}
-		catch(const std::exception & e)
-		{
-			logGlobal->error("Error: Failed to process %s: %s", file.getName(), e.what());
-		}
 	}
 }
 
@@ -132,6 +132,19 @@ void CMapHandler::prepareFOWDefs()
 		FoWpartialHide[frame] = graphics->fogOfWarPartialHide->getImage(frame);
 }
 
+// side of pre-rendered terrain chunk [in tiles]
+static const int TERRAIN_CHUNK_SIZE = 8;
+
+// tiles with palette animated in CMapHandler::updateWater()
+static bool hasAnimatedPalette(const TerrainTile & tinfo)
+{
+	return tinfo.terType == ETerrainType::LAVA
+		|| tinfo.terType == ETerrainType::WATER
+		|| tinfo.riverType == ERiverType::CLEAR_RIVER
+		|| tinfo.riverType == ERiverType::MUDDY_RIVER
+		|| tinfo.riverType == ERiverType::LAVA_RIVER;
+}
+
 EMapAnimRedrawStatus CMapHandler::drawTerrainRectNew(SDL_Surface * targetSurface, const MapDrawingInfo * info, bool redrawOnlyAnim)
 {
 	assert(info);
@@ -380,6 +393,7 @@ void CMapHandler::init()
 	offsetX = (mapW - (2*frameW+1)*32)/2;
 	offsetY = (mapH - (2*frameH+1)*32)/2;
 
+	invalidateTerrain();
 	prepareFOWDefs();
 	initTerrainGraphics();
 	initBorderGraphics();
@@ -462,6 +476,133 @@ SDL_Rect CMapHandler::CMapNormalBlitter::clip(SDL_Surface * targetSurf) const
 	return prevClip;
 }
 
+void CMapHandler::CMapNormalBlitter::drawTerrain(SDL_Surface * targetSurf)
+{
+	// visible part of map [in tiles]
+	const int firstX = std::max(topTile.x, 0);
+	const int firstY = std::max(topTile.y, 0);
+	const int lastX = std::min(topTile.x + tileCount.x, parent->sizes.x);
+	const int lastY = std::min(topTile.y + tileCount.y, parent->sizes.y);
+
+	auto isDrawable = [&](int x, int y) -> bool
+	{
+		pos = int3(x, y, topTile.z);
+		return info->showAllTerrain || canDrawCurrentTile();
+	};
+
+	parent->terrainChunkFrame++;
+
+	for(int chunkY = firstY / TERRAIN_CHUNK_SIZE; chunkY * TERRAIN_CHUNK_SIZE < lastY; chunkY++)
+	{
+		for(int chunkX = firstX / TERRAIN_CHUNK_SIZE; chunkX * TERRAIN_CHUNK_SIZE < lastX; chunkX++)
+		{
+			SDL_Surface * chunk = getTerrainChunk(int3(chunkX, chunkY, topTile.z), targetSurf);
+
+			auto blitTiles = [&](int x, int y, int width, int height)
+			{
+				Rect source((x - chunkX * TERRAIN_CHUNK_SIZE) * tileSize, (y - chunkY * TERRAIN_CHUNK_SIZE) * tileSize, width * tileSize, height * tileSize);
+				Rect dest(initPos.x + (x - topTile.x) * tileSize, initPos.y + (y - topTile.y) * tileSize, source.w, source.h);
+				CSDL_Ext::blitSurface(chunk, &source, targetSurf, &dest);
+			};
+
+			// visible part of chunk [in tiles]
+			const int beginX = std::max(firstX, chunkX * TERRAIN_CHUNK_SIZE);
+			const int beginY = std::max(firstY, chunkY * TERRAIN_CHUNK_SIZE);
+			const int endX = std::min(lastX, (chunkX + 1) * TERRAIN_CHUNK_SIZE);
+			const int endY = std::min(lastY, (chunkY + 1) * TERRAIN_CHUNK_SIZE);
+
+			bool fullyDrawable = true;
+			for(int y = beginY; y < endY && fullyDrawable; y++)
+				for(int x = beginX; x < endX && fullyDrawable; x++)
+					fullyDrawable = isDrawable(x, y);
+
+			if(fullyDrawable)
+			{
+				blitTiles(beginX, beginY, endX - beginX, endY - beginY);
+				continue;
+			}
+
+			// chunk on border of explored area - copy only rows of tiles that are not hidden
+			for(int y = beginY; y < endY; y++)
+			{
+				for(int x = beginX; x < endX; x++)
+				{
+					if(!isDrawable(x, y))
+						continue;
+
+					int runEnd = x + 1;
+					while(runEnd < endX && isDrawable(runEnd, y))
+						runEnd++;
+
+					blitTiles(x, y, runEnd - x, 1);
+					x = runEnd;
+				}
+			}
+		}
+	}
+
+	parent->evictTerrainChunks();
+}
+
+SDL_Surface * CMapHandler::CMapNormalBlitter::getTerrainChunk(const int3 & chunkPos, SDL_Surface * format)
+{
+	TerrainChunk & chunk = parent->terrainChunks[chunkPos];
+
+	if(!chunk.surface)
+	{
+		const int width = std::min(TERRAIN_CHUNK_SIZE, parent->sizes.x - chunkPos.x * TERRAIN_CHUNK_SIZE);
+		const int height = std::min(TERRAIN_CHUNK_SIZE, parent->sizes.y - chunkPos.y * TERRAIN_CHUNK_SIZE);
+
+		chunk.surface = CSDL_Ext::newSurface(width * tileSize, height * tileSize, format);
+		SDL_SetSurfaceBlendMode(chunk.surface, SDL_BLENDMODE_NONE);
+		renderTerrainChunk(chunk, chunkPos);
+	}
+	else if(chunk.animated && chunk.waterPhase != parent->waterPhase)
+	{
+		renderTerrainChunk(chunk, chunkPos);
+	}
+
+	chunk.lastUsedFrame = parent->terrainChunkFrame;
+	return chunk.surface;
+}
+
+void CMapHandler::CMapNormalBlitter::renderTerrainChunk(TerrainChunk & chunk, const int3 & chunkPos)
+{
+	// tile drawing methods use current position of blitter, restore it once chunk is ready
+	const int3 oldPos = pos;
+	const int3 oldRealPos = realPos;
+	const Rect oldTileRect = realTileRect;
+
+	chunk.animated = false;
+	chunk.waterPhase = parent->waterPhase;
+
+	for(int x = 0; x * tileSize < chunk.surface->w; x++)
+	{
+		for(int y = 0; y * tileSize < chunk.surface->h; y++)
+		{
+			pos = int3(chunkPos.x * TERRAIN_CHUNK_SIZE + x, chunkPos.y * TERRAIN_CHUNK_SIZE + y, chunkPos.z);
+			realPos = int3(x * tileSize, y * tileSize, 0);
+			realTileRect = Rect(realPos.x, realPos.y, tileSize, tileSize);
+
+			const TerrainTile2 & tile = parent->ttiles[pos.x][pos.y][pos.z];
+			const TerrainTile & tinfo = parent->map->getTile(pos);
+			const TerrainTile * tinfoUpper = pos.y > 0 ? &parent->map->getTile(int3(pos.x, pos.y - 1, pos.z)) : nullptr;
+
+			drawTileTerrain(chunk.surface, tinfo, tile);
+			if (tinfo.riverType)
+				drawRiver(chunk.surface, tinfo);
+			drawRoad(chunk.surface, tinfo, tinfoUpper);
+
+			if(hasAnimatedPalette(tinfo) || (tinfoUpper && hasAnimatedPalette(*tinfoUpper)))
+				chunk.animated = true;
+		}
+	}
+
+	pos = oldPos;
+	realPos = oldRealPos;
+	realTileRect = oldTileRect;
+}
+
 CMapHandler::CMapNormalBlitter::CMapNormalBlitter(CMapHandler * parent)
 	: CMapBlitter(parent)
 {
@@ -847,11 +988,8 @@ void CMapHandler::CMapBlitter::drawFow(SDL_Surface * targetSurf) const
 	drawElement(EMapCacheType::FOW, image, nullptr, targetSurf, &destRect);
 }
 
-void CMapHandler::CMapBlitter::blit(SDL_Surface * targetSurf, const MapDrawingInfo * info)
+void CMapHandler::CMapBlitter::drawTerrain(SDL_Surface * targetSurf)
 {
-	init(info);
-	auto prevClip = clip(targetSurf);
-
 	pos = int3(0, 0, topTile.z);
 
 	for (realPos.x = initPos.x, pos.x = topTile.x; pos.x < topTile.x + tileCount.x; pos.x++, realPos.x += tileSize)
@@ -864,7 +1002,8 @@ void CMapHandler::CMapBlitter::blit(SDL_Surface * targetSurf, const MapDrawingIn
 			if (pos.y < 0 || pos.y >= parent->sizes.y)
 				continue;
 
-			const bool isVisible = canDrawCurrentTile();
+			if(!info->showAllTerrain && !canDrawCurrentTile())
+				continue;
 
 			realTileRect.x = realPos.x;
 			realTileRect.y = realPos.y;
@@ -873,16 +1012,41 @@ void CMapHandler::CMapBlitter::blit(SDL_Surface * targetSurf, const MapDrawingIn
 			const TerrainTile & tinfo = parent->map->getTile(pos);
 			const TerrainTile * tinfoUpper = pos.y > 0 ? &parent->map->getTile(int3(pos.x, pos.y - 1, pos.z)) : nullptr;
 
-			if(isVisible || info->showAllTerrain)
-			{
-				drawTileTerrain(targetSurf, tinfo, tile);
-				if (tinfo.riverType)
-					drawRiver(targetSurf, tinfo);
-				drawRoad(targetSurf, tinfo, tinfoUpper);
-			}
+			drawTileTerrain(targetSurf, tinfo, tile);
+			if (tinfo.riverType)
+				drawRiver(targetSurf, tinfo);
+			drawRoad(targetSurf, tinfo, tinfoUpper);
+		}
+	}
+}
 
-			if(isVisible)
-				drawObjects(targetSurf, tile);
+void CMapHandler::CMapBlitter::blit(SDL_Surface * targetSurf, const MapDrawingInfo * info)
+{
+	init(info);
+	auto prevClip = clip(targetSurf);
+
+	// objects never cover tiles drawn after them, so all terrain can be drawn before objects
+	drawTerrain(targetSurf);
+
+	pos = int3(0, 0, topTile.z);
+
+	for (realPos.x = initPos.x, pos.x = topTile.x; pos.x < topTile.x + tileCount.x; pos.x++, realPos.x += tileSize)
+	{
+		if (pos.x < 0 || pos.x >= parent->sizes.x)
+			continue;
+
+		for (realPos.y = initPos.y, pos.y = topTile.y; pos.y < topTile.y + tileCount.y; pos.y++, realPos.y += tileSize)
+		{
+			if (pos.y < 0 || pos.y >= parent->sizes.y)
+				continue;
+
+			if(!canDrawCurrentTile())
+				continue;
+
+			realTileRect.x = realPos.x;
+			realTileRect.y = realPos.y;
+
+			drawObjects(targetSurf, parent->ttiles[pos.x][pos.y][pos.z]);
 		}
 	}
 
@@ -1326,6 +1490,8 @@ bool CMapHandler::canStartHeroMovement()
 
 void CMapHandler::updateWater() //shift colors in palettes of water tiles
 {
+	waterPhase++;
+
 	for(auto & elem : terrainImages[7])
 	{
 		for(auto img : elem)
@@ -1367,8 +1533,47 @@ void CMapHandler::updateWater() //shift colors in palettes of water tiles
 	}
 }
 
+void CMapHandler::invalidateTerrain(const int3 & tile)
+{
+	// road of tile is partially drawn on the tile below it
+	for(int y : {tile.y, tile.y + 1})
+	{
+		auto chunk = terrainChunks.find(int3(tile.x / TERRAIN_CHUNK_SIZE, y / TERRAIN_CHUNK_SIZE, tile.z));
+		if(chunk != terrainChunks.end())
+		{
+			SDL_FreeSurface(chunk->second.surface);
+			terrainChunks.erase(chunk);
+		}
+	}
+}
+
+void CMapHandler::invalidateTerrain()
+{
+	for(auto & chunk : terrainChunks)
+		SDL_FreeSurface(chunk.second.surface);
+	terrainChunks.clear();
+}
+
+void CMapHandler::evictTerrainChunks()
+{
+	const size_t screenChunks = (tilesW / TERRAIN_CHUNK_SIZE + 2) * (tilesH / TERRAIN_CHUNK_SIZE + 2);
+
+	while(terrainChunks.size() > 4 * screenChunks)
+	{
+		auto oldest = terrainChunks.begin();
+		for(auto chunk = terrainChunks.begin(); chunk != terrainChunks.end(); ++chunk)
+		{
+			if(chunk->second.lastUsedFrame < oldest->second.lastUsedFrame)
+				oldest = chunk;
+		}
+		SDL_FreeSurface(oldest->second.surface);
+		terrainChunks.erase(oldest);
+	}
+}
+
 CMapHandler::~CMapHandler()
 {
+	invalidateTerrain();
 	delete normalBlitter;
 	delete worldViewBlitter;
 	delete puzzleViewBlitter;
@@ -1386,6 +1591,8 @@ CMapHandler::CMapHandler()
 	worldViewBlitter = new CMapWorldViewBlitter(this);
 	puzzleViewBlitter = new CMapPuzzleViewBlitter(this);
 	fadeAnimCounter = 0;
+	waterPhase = 0;
+	terrainChunkFrame = 0;
 	map = nullptr;
 	tilesW = tilesH = 0;
 	offsetX = offsetY = 0;
@@ -193,6 +193,22 @@ class CMapHandler
 		{}
 	};
 
+	/// terrain, river and road layers of square map area, rendered once and reused by normal blitter
+	struct TerrainChunk
+	{
+		SDL_Surface * surface;
+		bool animated; // has tiles with palette shifted by updateWater()
+		ui32 waterPhase; // value of waterPhase when surface was rendered
+		ui32 lastUsedFrame;
+
+		TerrainChunk()
+			: surface(nullptr),
+			  animated(false),
+			  waterPhase(0),
+			  lastUsedFrame(0)
+		{}
+	};
+
 	class CMapBlitter
 	{
 	protected:
@@ -214,6 +230,8 @@ class CMapHandler
 
 		// first drawing pass
 
+		/// draws terrain, rivers and roads of all tiles in viewport
+		virtual void drawTerrain(SDL_Surface * targetSurf);
 		/// draws terrain bitmap (or custom bitmap if applicable) on current tile
 		virtual void drawTileTerrain(SDL_Surface * targetSurf, const TerrainTile & tinfo, const TerrainTile2 & tile) const;
 		/// draws a river segment on current tile
@@ -277,6 +295,11 @@ class CMapHandler
 		void drawTileOverlay(SDL_Surface * targetSurf,const TerrainTile2 & tile) const override {}
 		void init(const MapDrawingInfo * info) override;
 		SDL_Rect clip(SDL_Surface * targetSurf) const override;
+		/// draws terrain layers from pre-rendered chunks instead of separate tiles
+		void drawTerrain(SDL_Surface * targetSurf) override;
+		/// returns surface of chunk with given coordinates, rendering it if needed
+		SDL_Surface * getTerrainChunk(const int3 & chunkPos, SDL_Surface * format);
+		void renderTerrainChunk(TerrainChunk & chunk, const int3 & chunkPos);
 	public:
 		CMapNormalBlitter(CMapHandler * parent);
 		virtual ~CMapNormalBlitter(){}
@@ -315,6 +338,13 @@ class CMapHandler
 		CMapPuzzleViewBlitter(CMapHandler * parent);
 	};
 
+	std::map<int3, TerrainChunk> terrainChunks; //[chunk coordinates]
+	ui32 waterPhase; // incremented on every palette shift of water tiles
+	ui32 terrainChunkFrame; // incremented on every terrain drawing, used to find least recently used chunks
+
+	/// frees least recently used chunks once there are more of them than several screens can show
+	void evictTerrainChunks();
+
 	CMapCache cache;
 	CMapBlitter * normalBlitter;
 	CMapBlitter * worldViewBlitter;
@@ -389,6 +419,10 @@ public:
 
 	EMapAnimRedrawStatus drawTerrainRectNew(SDL_Surface * targetSurface, const MapDrawingInfo * info, bool redrawOnlyAnim = false);
 	void updateWater();
+	/// discards pre-rendered terrain affected by given tile, must be called after change of its terrain, river or road
+	void invalidateTerrain(const int3 & tile);
+	/// discards all pre-rendered terrain
+	void invalidateTerrain();
 	/// determines if the map is ready to handle new hero movement (not available during fading animations)
 	bool canStartHeroMovement();
 
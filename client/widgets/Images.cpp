@@ -307,7 +307,9 @@ CShowableAnim::CShowableAnim(int x, int y, std::string name, ui8 Flags, ui32 Del
 	yOffset(0),
 	alpha(255)
 {
-	anim->loadGroup(group);
+	//first frame is needed for size and as placeholder, rest of group is decoded in background
+	anim->load(0, group);
+	anim->prefetchGroup(group);
 	last = anim->size(group);
 
 	pos.w = anim->getImage(0, group)->width();
@@ -337,7 +339,8 @@ bool CShowableAnim::set(size_t Group, size_t from, size_t to)
 		return false;
 
 	anim->unloadGroup(group);
-	anim->loadGroup(Group);
+	anim->load(from, Group);
+	anim->prefetchGroup(Group);
 
 	group = Group;
 	frame = first = from;
@@ -353,7 +356,8 @@ bool CShowableAnim::set(size_t Group)
 	if (group != Group)
 	{
 		anim->unloadGroup(group);
-		anim->loadGroup(Group);
+		anim->load(0, Group);
+		anim->prefetchGroup(Group);
 
 		first = 0;
 		group = Group;
@@ -408,7 +412,8 @@ void CShowableAnim::blitImage(size_t frame, size_t group, SDL_Surface *to)
 {
 	assert(to);
 	Rect src( xOffset, yOffset, pos.w, pos.h);
-	auto img = anim->getImage(frame, group);
+	//frame that is still being decoded is replaced with first one
+	auto img = anim->getImageOrPlaceholder(frame, group, anim->getImage(first, group, false));
 	if(img)
 		img->draw(to, pos.x, pos.y, &src, alpha);
 }
@@ -22,6 +22,7 @@
 #include "../CMusicHandler.h"
 #include "../CPlayerInterface.h"
 #include "../Graphics.h"
+#include "../gui/CAnimation.h"
 #include "../gui/CGuiHandler.h"
 #include "../gui/SDL_Extensions.h"
 #include "../windows/InfoWindows.h"
@@ -555,6 +556,15 @@ CCastleBuildings::CCastleBuildings(const CGTownInstance* Town):
 {
 	OBJECT_CONSTRUCTION_CAPTURING(255-DISPOSE);
 
+	//building animations are read on worker threads while background is loaded
+	std::vector<std::string> buildingAnimations;
+	for(const CStructure * structure : town->town->clientInfo.structures)
+	{
+		if(!structure->building || vstd::contains(town->builtBuildings, structure->building->bid))
+			buildingAnimations.push_back(structure->defName);
+	}
+	CAnimation::prefetchFiles(buildingAnimations);
+
 	background = std::make_shared<CPicture>(town->town->clientInfo.townBackground);
 	pos.w = background->pos.w;
 	pos.h = background->pos.h;
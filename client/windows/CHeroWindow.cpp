@@ -40,10 +40,10 @@
 #include "../mapHandler.h"
 
 
-TConstBonusListPtr CHeroWithMaybePickedArtifact::getAllBonuses(const CSelector & selector, const CSelector & limit, const CBonusSystemNode * root, const std::string & cachingStr) const
+TConstBonusListPtr CHeroWithMaybePickedArtifact::getAllBonuses(const CSelector & selector, const CSelector & limit, const CBonusSystemNode * root, const BonusCacheKey & cachingKey) const
 {
 	TBonusListPtr out(new BonusList());
-	TConstBonusListPtr heroBonuses = hero->getAllBonuses(selector, limit, hero, cachingStr);
+	TConstBonusListPtr heroBonuses = hero->getAllBonuses(selector, limit, hero, cachingKey);
 	TConstBonusListPtr bonusesFromPickedUpArtifact;
 
 	std::shared_ptr<CArtifactsOfHero::SCommonPart> cp = cww->getCommonPart();
@@ -47,7 +47,7 @@ public:
 	CWindowWithArtifacts * cww;
 
 	CHeroWithMaybePickedArtifact(CWindowWithArtifacts * Cww, const CGHeroInstance * Hero);
-	TConstBonusListPtr getAllBonuses(const CSelector & selector, const CSelector & limit, const CBonusSystemNode * root = nullptr, const std::string & cachingStr = "") const override;
+	TConstBonusListPtr getAllBonuses(const CSelector & selector, const CSelector & limit, const CBonusSystemNode * root = nullptr, const BonusCacheKey & cachingKey = BonusCacheKey()) const override;
 
 	int64_t getTreeVersion() const override;
 };
@@ -263,6 +263,7 @@ void CCreature::addBonus(int val, Bonus::BonusType type, int subtype)
 	{
 		std::shared_ptr<Bonus> b = existing[0];
 		b->val = val;
+		nodeHasChanged();
 	}
 }
 
@@ -21,10 +21,14 @@
 #include "mapObjects/CObjectHandler.h"
 #include "StringConstants.h"
 #include "CStopWatch.h"
+#include "CThreadHelper.h"
 #include "IHandlerBase.h"
 #include "spells/CSpellHandler.h"
 #include "CSkillHandler.h"
 #include "ScriptHandler.h"
+#include "VCMIDirs.h"
+#include "serializer/BinaryDeserializer.h"
+#include "serializer/BinarySerializer.h"
 
 #include <vstd/StringUtils.h>
 
@@ -312,10 +316,8 @@ ContentTypeHandler::ContentTypeHandler(IHandlerBase * handler, std::string objec
 	}
 }
 
-bool ContentTypeHandler::preloadModData(std::string modName, std::vector<std::string> fileList, bool validate)
+void ContentTypeHandler::preloadModData(std::string modName, JsonNode data)
 {
-	bool result;
-	JsonNode data = JsonUtils::assembleFromFiles(fileList, result);
 	data.setMeta(modName);
 
 	ModInfo & modInfo = modData[modName];
@@ -344,7 +346,6 @@ bool ContentTypeHandler::preloadModData(std::string modName, std::vector<std::st
 			JsonUtils::merge(remoteConf, entry.second);
 		}
 	}
-	return result;
 }
 
 bool ContentTypeHandler::loadMod(std::string modName, bool validate)
@@ -427,16 +428,6 @@ void CContentHandler::init()
 	//TODO: any other types of moddables?
 }
 
-bool CContentHandler::preloadModData(std::string modName, JsonNode modConfig, bool validate)
-{
-	bool result = true;
-	for(auto & handler : handlers)
-	{
-		result &= handler.second.preloadModData(modName, modConfig[handler.first].convertTo<std::vector<std::string> >(), validate);
-	}
-	return result;
-}
-
 bool CContentHandler::loadMod(std::string modName, bool validate)
 {
 	bool result = true;
@@ -463,20 +454,38 @@ void CContentHandler::afterLoadFinalization()
 	}
 }
 
-void CContentHandler::preloadData(CModInfo & mod)
+CContentHandler::ParsedModData CContentHandler::parseData(const CModInfo & mod) const
 {
 	bool validate = (mod.validation != CModInfo::PASSED);
 
-	// print message in format [<8-symbols checksum>] <modname>
-	logMod->info("\t\t[%08x]%s", mod.checksum, mod.name);
+	ParsedModData result;
+	result.valid = true;
 
 	if (validate && mod.identifier != "core")
 	{
 		if (!JsonUtils::validate(mod.config, "vcmi:mod", mod.identifier))
-			mod.validation = CModInfo::FAILED;
+			result.valid = false;
 	}
-	if (!preloadModData(mod.identifier, mod.config, validate))
+
+	for(auto & handler : handlers)
+	{
+		bool filesValid;
+		result.content[handler.first] = JsonUtils::assembleFromFiles(mod.config[handler.first].convertTo<std::vector<std::string> >(), filesValid);
+		result.valid &= filesValid;
+	}
+	return result;
+}
+
+void CContentHandler::preloadData(CModInfo & mod, ParsedModData & data)
+{
+	// print message in format [<8-symbols checksum>] <modname>
+	logMod->info("\t\t[%08x]%s", mod.checksum, mod.name);
+
+	if (!data.valid)
 		mod.validation = CModInfo::FAILED;
+
+	for(auto & handler : handlers)
+		handler.second.preloadModData(mod.identifier, std::move(data.content[handler.first]));
 }
 
 void CContentHandler::load(CModInfo & mod)
@@ -497,6 +506,62 @@ void CContentHandler::load(CModInfo & mod)
 		logMod->info("\t\t[SKIP] %s", mod.name);
 }
 
+static const std::string MOD_CONTENT_CACHE_MAGIC = "VCMIMCC";
+
+void CContentHandler::saveCache(const boost::filesystem::path & cacheFile, ui32 checksum) const
+{
+	try
+	{
+		CSaveFile file(cacheFile);
+		file.putMagicBytes(MOD_CONTENT_CACHE_MAGIC);
+		file << checksum;
+		for(auto & handler : handlers)
+			file << handler.first << handler.second.modData;
+	}
+	catch(const std::exception & e)
+	{
+		logMod->warn("Failed to save mod data cache %s: %s", cacheFile.string(), e.what());
+	}
+}
+
+bool CContentHandler::loadCache(const boost::filesystem::path & cacheFile, ui32 checksum)
+{
+	if(!boost::filesystem::exists(cacheFile))
+		return false;
+
+	try
+	{
+		//format of JsonNode follows serialization version, cache from any other version is ignored
+		CLoadFile file(cacheFile, SERIALIZATION_VERSION);
+		file.checkMagicBytes(MOD_CONTENT_CACHE_MAGIC);
+
+		ui32 cachedChecksum;
+		file >> cachedChecksum;
+		if(cachedChecksum != checksum)
+		{
+			logMod->debug("Mod data cache %s is outdated", cacheFile.string());
+			return false;
+		}
+
+		for(auto & handler : handlers)
+		{
+			std::string name;
+			file >> name;
+			if(name != handler.first)
+				throw std::runtime_error("Unexpected content type " + name);
+			file >> handler.second.modData;
+		}
+		return true;
+	}
+	catch(const std::exception & e)
+	{
+		logMod->warn("Failed to load mod data cache %s: %s", cacheFile.string(), e.what());
+		for(auto & handler : handlers)
+			handler.second.modData.clear();
+		return false;
+	}
+}
+
 const ContentTypeHandler & CContentHandler::operator[](const std::string & name) const
 {
 	return handlers.at(name);
@@ -958,18 +1023,66 @@ void CModHandler::load()
 
 	content->init();
 
+	// first - load virtual "core" mod that contains all data
+	// TODO? move all data into real mods? RoE, AB, SoD, WoG
+	std::vector<CModInfo *> mods;
+	mods.push_back(&coreMod);
 	for(const TModID & modName : activeMods)
+		mods.push_back(&allMods[modName]);
+
+	// mods are independent until their data is passed to handlers, so files are read on all cores
+	const int threads = std::max<int>(1, boost::thread::hardware_concurrency());
+
+	std::vector<ui32> checksums(mods.size());
+	std::vector<CThreadHelper::Task> tasks;
+	for(size_t i = 1; i < mods.size(); i++) //checksum of core was calculated together with its filesystem
 	{
-		logMod->trace("Generating checksum for %s", modName);
-		allMods[modName].updateChecksum(calculateModChecksum(modName, CResourceHandler::get(modName)));
+		tasks.push_back([&checksums, &mods, i]()
+		{
+			logMod->trace("Generating checksum for %s", mods[i]->identifier);
+			checksums[i] = calculateModChecksum(mods[i]->identifier, CResourceHandler::get(mods[i]->identifier));
+		});
 	}
+	CThreadHelper(&tasks, threads).run();
 
-	// first - load virtual "core" mod that contains all data
-	// TODO? move all data into real mods? RoE, AB, SoD, WoG
-	content->preloadData(coreMod);
-	for(const TModID & modName : activeMods)
-		content->preloadData(allMods[modName]);
-	logMod->info("\tParsing mod data: %d ms", timer.getDiff());
+	for(size_t i = 1; i < mods.size(); i++)
+		mods[i]->updateChecksum(checksums[i]);
+	logMod->info("\tCalculating checksums: %d ms", timer.getDiff());
+
+	// data of mods that were already validated can be taken from cache if no mod has changed
+	boost::crc_32_type contentChecksum;
+	bool allValidated = true;
+	for(const CModInfo * mod : mods)
+	{
+		contentChecksum.process_bytes(mod->identifier.data(), mod->identifier.size());
+		contentChecksum.process_bytes(&mod->checksum, sizeof(mod->checksum));
+		allValidated &= (mod->validation == CModInfo::PASSED);
+	}
+	const auto cacheFile = VCMIDirs::get().userCachePath() / "modData.vcache";
+
+	if(allValidated && content->loadCache(cacheFile, contentChecksum.checksum()))
+	{
+		logMod->info("\tLoading cached mod data: %d ms", timer.getDiff());
+	}
+	else
+	{
+		std::vector<CContentHandler::ParsedModData> parsed(mods.size());
+		tasks.clear();
+		for(size_t i = 0; i < mods.size(); i++)
+		{
+			tasks.push_back([this, &parsed, &mods, i]()
+			{
+				parsed[i] = content->parseData(*mods[i]);
+			});
+		}
+		CThreadHelper(&tasks, threads).run();
+		logMod->info("\tParsing mod data: %d ms", timer.getDiff());
+
+		for(size_t i = 0; i < mods.size(); i++)
+			content->preloadData(*mods[i], parsed[i]);
+		content->saveCache(cacheFile, contentChecksum.checksum());
+		logMod->info("\tPreloading mod data: %d ms", timer.getDiff());
+	}
 
 	content->load(coreMod);
 	for(const TModID & modName : activeMods)
@@ -118,6 +118,12 @@ public:
 		JsonNode modData;
 		/// mod data for this mod from other mods (patches)
 		JsonNode patches;
+
+		template <typename Handler> void serialize(Handler &h, const int version)
+		{
+			h & modData;
+			h & patches;
+		}
 	};
 	/// handler to which all data will be loaded
 	IHandlerBase * handler;
@@ -131,7 +137,7 @@ public:
 
 	/// local version of methods in ContentHandler
 	/// returns true if loading was successful
-	bool preloadModData(std::string modName, std::vector<std::string> fileList, bool validate);
+	void preloadModData(std::string modName, JsonNode data);
 	bool loadMod(std::string modName, bool validate);
 	void loadCustom();
 	void afterLoadFinalization();
@@ -140,20 +146,34 @@ public:
 /// class used to load all game data into handlers. Used only during loading
 class DLL_LINKAGE CContentHandler
 {
-	/// preloads all data from fileList as data from modName.
-	bool preloadModData(std::string modName, JsonNode modConfig, bool validate);
-
 	/// actually loads data in mod
 	bool loadMod(std::string modName, bool validate);
 
 	std::map<std::string, ContentTypeHandler> handlers;
 public:
+	/// data files of one mod, read but not passed to handlers yet
+	struct ParsedModData
+	{
+		/// merged data of all files for each content type
+		std::map<std::string, JsonNode> content;
+		bool valid;
+	};
+
 	CContentHandler();
 
 	void init();
 
-	/// preloads all data from fileList as data from modName.
-	void preloadData(CModInfo & mod);
+	/// reads data files listed in mod config and validates config itself
+	/// does not modify any handler so mods can be parsed concurrently
+	ParsedModData parseData(const CModInfo & mod) const;
+
+	/// preloads parsed data as data from mod, must be called for mods in load order
+	void preloadData(CModInfo & mod, ParsedModData & data);
+
+	/// stores preloaded data of all mods, valid as long as checksum of all mods is the same
+	void saveCache(const boost::filesystem::path & cacheFile, ui32 checksum) const;
+	/// restores preloaded data instead of parsing mod files, returns false if cache is missing or outdated
+	bool loadCache(const boost::filesystem::path & cacheFile, ui32 checksum);
 
 	/// actually loads data in mod
 	void load(CModInfo & mod);
@@ -28,46 +28,58 @@ bool canSeeObj(const CGObjectInstance * obj)
 
 void NodeStorage::initialize(const PathfinderOptions & options, const CGameState * gs, const CGHeroInstance * hero)
 {
-	//TODO: fix this code duplication with AINodeStorage::initialize, problem is to keep `resetTile` inline
+	out.searchKey = PathfinderSearchKey(gs, hero);
 
-	int3 pos;
-	const int3 sizes = gs->getMapSize();
-	const auto & fow = static_cast<const CGameInfoCallback *>(gs)->getPlayerTeam(hero->tempOwner)->fogOfWarMap;
-	const PlayerColor player = hero->tempOwner;
+	PathfinderUtil::evaluateTiles(options, gs, hero, [this](const int3 & pos, ELayer layer, CGPathNode::EAccessibility accessibility)
+	{
+		resetTile(pos, layer, accessibility);
+	});
+}
 
-	//make 200% sure that these are loop invariants (also a bit shorter code), let compiler do the rest(loop unswitching)
-	const bool useFlying = options.useFlying;
-	const bool useWaterWalking = options.useWaterWalking;
+bool NodeStorage::reuseSearch(
+	const PathfinderOptions & options,
+	const CGameState * gs,
+	const CGHeroInstance * hero,
+	std::vector<CGPathNode *> & initialNodes)
+{
+	if(!(out.searchKey == PathfinderSearchKey(gs, hero)))
+		return false;
 
-	for(pos.x=0; pos.x < sizes.x; ++pos.x)
-	{
-		for(pos.y=0; pos.y < sizes.y; ++pos.y)
-		{
-			for(pos.z=0; pos.z < sizes.z; ++pos.z)
-			{
-				const TerrainTile * tile = &gs->map->getTile(pos);
-				switch(tile->terType)
-				{
-				case ETerrainType::ROCK:
-					break;
+	const int3 pos = hero->getPosition(false);
+	CGPathNode * root = getNode(pos, hero->boat ? ELayer::SAIL : ELayer::LAND);
 
-				case ETerrainType::WATER:
-					resetTile(pos, ELayer::SAIL, PathfinderUtil::evaluateAccessibility<ELayer::SAIL>(pos, tile, fow, player, gs));
-					if(useFlying)
-						resetTile(pos, ELayer::AIR, PathfinderUtil::evaluateAccessibility<ELayer::AIR>(pos, tile, fow, player, gs));
-					if(useWaterWalking)
-						resetTile(pos, ELayer::WATER, PathfinderUtil::evaluateAccessibility<ELayer::WATER>(pos, tile, fow, player, gs));
-					break;
+	if(!root || !root->reachable() || root->turns || root->moveRemains != hero->movement)
+		return false;
 
-				default:
-					resetTile(pos, ELayer::LAND, PathfinderUtil::evaluateAccessibility<ELayer::LAND>(pos, tile, fow, player, gs));
-					if(useFlying)
-						resetTile(pos, ELayer::AIR, PathfinderUtil::evaluateAccessibility<ELayer::AIR>(pos, tile, fow, player, gs));
-					break;
-				}
-			}
-		}
+	//hero moved along previous paths, new position should not be special in any way
+	if(root->theNodeBefore)
+	{
+		if(gs->guardingCreaturePosition(pos).valid() || gs->map->getTile(pos).visitableObjects.size() != 1)
+			return false;
 	}
+
+	std::vector<bool> dirtyTiles(out.sizes.x * out.sizes.y * out.sizes.z);
+
+	PathfinderUtil::evaluateTiles(options, gs, hero, [&](const int3 & pos, ELayer layer, CGPathNode::EAccessibility accessibility)
+	{
+		out.allocateLayer(layer);
+
+		CGPathNode * node = out.getNode(pos, layer);
+
+		//nodes are reset later if their paths are affected, initial node may be on changed tile too
+		if(node->layer == ELayer::WRONG)
+			node->update(pos, layer, accessibility);
+		else if(node->accessible != accessibility)
+			node->accessible = accessibility;
+		else
+			return;
+
+		dirtyTiles[out.getTileIndex(pos)] = true;
+	});
+
+	initialNodes = PathfinderUtil::rerootTree(out.nodes, out.sizes, root, dirtyTiles, gs);
+
+	return true;
 }
 
 std::vector<CGPathNode *> NodeStorage::calculateNeighbours(
@@ -85,7 +97,7 @@ std::vector<CGPathNode *> NodeStorage::calculateNeighbours(
 		{
 			auto node = getNode(neighbour, i);
 
-			if(node->accessible == CGPathNode::NOT_SET)
+			if(!node || node->accessible == CGPathNode::NOT_SET)
 				continue;
 
 			neighbours.push_back(node);
@@ -152,7 +164,35 @@ void NodeStorage::resetTile(
 	EPathfindingLayer layer,
 	CGPathNode::EAccessibility accessibility)
 {
-	getNode(tile, layer)->update(tile, layer, accessibility);
+	out.allocateLayer(layer);
+	out.getNode(tile, layer)->update(tile, layer, accessibility);
+}
+
+PathfinderSearchKey::PathfinderSearchKey()
+	: hero(nullptr), day(0), bonusTreeVersion(0), mana(0), spells(0), maxMovePointsLand(0), maxMovePointsSea(0)
+{
+}
+
+PathfinderSearchKey::PathfinderSearchKey(const CGameState * gs, const CGHeroInstance * hero)
+	: hero(hero),
+	day(gs->day),
+	bonusTreeVersion(hero->getTreeVersion()),
+	mana(hero->mana),
+	spells(hero->getSpellsInSpellbook().size()),
+	maxMovePointsLand(hero->maxMovePoints(true)),
+	maxMovePointsSea(hero->maxMovePoints(false))
+{
+}
+
+bool PathfinderSearchKey::operator==(const PathfinderSearchKey & other) const
+{
+	return hero == other.hero
+		&& day == other.day
+		&& bonusTreeVersion == other.bonusTreeVersion
+		&& mana == other.mana
+		&& spells == other.spells
+		&& maxMovePointsLand == other.maxMovePointsLand
+		&& maxMovePointsSea == other.maxMovePointsSea;
 }
 
 CGPathNode * NodeStorage::getInitialNode()
@@ -287,6 +327,10 @@ CPathfinder::CPathfinder(
 
 	initializePatrol();
 	initializeGraph();
+
+	//open list is a single vector, allocate it once for typical search front
+	const int3 sizes = getMapSize();
+	pq.reserve(sizes.x * sizes.y);
 }
 
 
@@ -296,8 +340,7 @@ void CPathfinder::push(CGPathNode * node)
 	{
 		node->inPQ = true;
 		node->pq = &this->pq;
-		auto handle = pq.push(node);
-		node->pqHandle = handle;
+		pq.push(node);
 	}
 }
 
@@ -329,6 +372,9 @@ void CPathfinder::calculatePaths()
 
 	push(initialNode);
 
+	for(CGPathNode * node : initialNodes)
+		push(node);
+
 	while(!pq.empty())
 	{
 		auto node = topAndPop();
@@ -934,6 +980,14 @@ void CPathfinder::initializePatrol()
 void CPathfinder::initializeGraph()
 {
 	INodeStorage * nodeStorage = config->nodeStorage.get();
+
+	/// Both change meaning of initial position, trees found for other position can't be reused
+	if(patrolState == PATROL_NONE && !config->options.lightweightFlyingMode)
+	{
+		if(nodeStorage->reuseSearch(config->options, gs, hero, initialNodes))
+			return;
+	}
+
 	nodeStorage->initialize(config->options, gs, hero);
 }
 
@@ -1034,7 +1088,7 @@ TurnInfo::BonusCache::BonusCache(TConstBonusListPtr bl)
 TurnInfo::TurnInfo(const CGHeroInstance * Hero, const int turn)
 	: hero(Hero), maxMovePointsLand(-1), maxMovePointsWater(-1)
 {
-	bonuses = hero->getAllBonuses(Selector::days(turn), Selector::all, nullptr, "");
+	bonuses = hero->getAllBonuses(Selector::days(turn), Selector::all, nullptr);
 	bonusCache = make_unique<BonusCache>(bonuses);
 	nativeTerrain = hero->getNativeTerrain();
 }
@@ -1309,7 +1363,7 @@ void CGPath::convert(ui8 mode)
 CPathsInfo::CPathsInfo(const int3 & Sizes, const CGHeroInstance * hero_)
 	: sizes(Sizes), hero(hero_)
 {
-	nodes.resize(boost::extents[sizes.x][sizes.y][sizes.z][ELayer::NUM_LAYERS]);
+	allocateLayer(ELayer::LAND);
 }
 
 CPathsInfo::~CPathsInfo() = default;
@@ -1341,11 +1395,18 @@ bool CPathsInfo::getPath(CGPath & out, const int3 & dst) const
 
 const CGPathNode * CPathsInfo::getNode(const int3 & coord) const
 {
-	auto landNode = &nodes[coord.x][coord.y][coord.z][ELayer::LAND];
-	if(landNode->reachable())
+	const size_t index = getTileIndex(coord);
+	auto landNode = &nodes[ELayer::LAND][index];
+	if(landNode->reachable() || !hasLayer(ELayer::SAIL))
 		return landNode;
 	else
-		return &nodes[coord.x][coord.y][coord.z][ELayer::SAIL];
+		return &nodes[ELayer::SAIL][index];
+}
+
+void CPathsInfo::allocateLayer(const ELayer layer)
+{
+	if(!hasLayer(layer))
+		nodes[layer].resize(sizes.x * sizes.y * sizes.z);
 }
 
 PathNodeInfo::PathNodeInfo()
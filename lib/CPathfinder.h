@@ -13,8 +13,7 @@
 #include "IGameCallback.h"
 #include "HeroBonus.h"
 #include "int3.h"
-
-#include <boost/heap/fibonacci_heap.hpp>
+#include "PathfinderQueue.h"
 
 
 class CGHeroInstance;
@@ -28,16 +27,6 @@ class CPathfinder;
 class PathfinderConfig;
 
 
-template<typename N>
-struct DLL_LINKAGE NodeComparer
-{
-	STRONG_INLINE
-	bool operator()(const N * lhs, const N * rhs) const
-	{
-		return lhs->getCost() > rhs->getCost();
-	}
-};
-
 struct DLL_LINKAGE CGPathNode
 {
 	typedef EPathfindingLayer ELayer;
@@ -66,21 +55,21 @@ struct DLL_LINKAGE CGPathNode
 		BLOCKED //tile can't be entered nor visited
 	};
 
+	//fields are ordered to avoid padding, nodes are allocated for every tile of every used layer
 	CGPathNode * theNodeBefore;
 	int3 coord; //coordinates
 	ELayer layer;
-	ui32 moveRemains; //remaining movement points after hero reaches the tile
 	ui8 turns; //how many turns we have to wait before reaching the tile - 0 means current turn
-
 	EAccessibility accessible;
 	ENodeAction action;
 	bool locked;
 	bool inPQ;
+	ui32 moveRemains; //remaining movement points after hero reaches the tile
 
 	CGPathNode()
 		: coord(-1),
 		layer(ELayer::WRONG),
-		pqHandle(nullptr)
+		pqIndex(0)
 	{
 		reset();
 	}
@@ -111,20 +100,11 @@ struct DLL_LINKAGE CGPathNode
 		if(value == cost)
 			return;
 
-		bool getUpNode = value < cost;
+		float oldCost = cost;
 		cost = value;
-		// If the node is in the heap, update the heap.
+		// If the node is in the queue, update its position.
 		if(inPQ && pq != nullptr)
-		{
-			if(getUpNode)
-			{
-				pq->increase(this->pqHandle);
-			}
-			else
-			{
-				pq->decrease(this->pqHandle);
-			}
-		}
+			pq->update(this, oldCost);
 	}
 
 	STRONG_INLINE
@@ -149,13 +129,10 @@ struct DLL_LINKAGE CGPathNode
 		return turns < 255;
 	}
 
-	typedef boost::heap::fibonacci_heap<
-		CGPathNode *,
-		boost::heap::compare<NodeComparer<CGPathNode>>
-	> TFibHeap;
+	typedef PathfinderQueue<CGPathNode> TPriorityQueue;
 
-	TFibHeap::handle_type pqHandle;
-	TFibHeap* pq;
+	TPriorityQueue * pq;
+	ui32 pqIndex; //position in queue, see PathfinderQueue.h
 
 private:
 	float cost; //total cost of the path to this tile measured in turns with fractions
@@ -170,6 +147,24 @@ struct DLL_LINKAGE CGPath
 	void convert(ui8 mode); //mode=0 -> from 'manifest' to 'object'
 };
 
+/// State of hero and game which found paths depend on, besides the map.
+/// Paths are only updated incrementally if it did not change, map changes are found by comparing tile accessibility.
+struct DLL_LINKAGE PathfinderSearchKey
+{
+	const CGHeroInstance * hero;
+	ui32 day;
+	int64_t bonusTreeVersion;
+	si32 mana;
+	size_t spells;
+	int maxMovePointsLand; //depends on speed of army, which is not part of hero bonus tree
+	int maxMovePointsSea;
+
+	PathfinderSearchKey();
+	PathfinderSearchKey(const CGameState * gs, const CGHeroInstance * hero);
+
+	bool operator==(const PathfinderSearchKey & other) const;
+};
+
 struct DLL_LINKAGE CPathsInfo
 {
 	typedef EPathfindingLayer ELayer;
@@ -177,18 +172,35 @@ struct DLL_LINKAGE CPathsInfo
 	const CGHeroInstance * hero;
 	int3 hpos;
 	int3 sizes;
-	boost::multi_array<CGPathNode, 4> nodes; //[w][h][level][layer]
+	/// [layer][level][h][w], neighbour tiles of same layer are close in memory
+	/// Land layer is always allocated, others only once pathfinder uses them
+	std::array<std::vector<CGPathNode>, ELayer::NUM_LAYERS> nodes;
+	PathfinderSearchKey searchKey; //what nodes were calculated for
 
 	CPathsInfo(const int3 & Sizes, const CGHeroInstance * hero_);
 	~CPathsInfo();
 	const CGPathNode * getPathInfo(const int3 & tile) const;
 	bool getPath(CGPath & out, const int3 & dst) const;
 	const CGPathNode * getNode(const int3 & coord) const;
+	void allocateLayer(const ELayer layer);
+
+	STRONG_INLINE
+	bool hasLayer(const ELayer layer) const
+	{
+		return !nodes[layer].empty();
+	}
+
+	STRONG_INLINE
+	size_t getTileIndex(const int3 & coord) const
+	{
+		return (coord.z * sizes.y + coord.y) * sizes.x + coord.x;
+	}
 
 	STRONG_INLINE
 	CGPathNode * getNode(const int3 & coord, const ELayer layer)
 	{
-		return &nodes[coord.x][coord.y][coord.z][layer];
+		assert(hasLayer(layer));
+		return &nodes[layer][getTileIndex(coord)];
 	}
 };
 
@@ -394,6 +406,19 @@ public:
 	virtual void commit(CDestinationNodeInfo & destination, const PathNodeInfo & source) = 0;
 
 	virtual void initialize(const PathfinderOptions & options, const CGameState * gs, const CGHeroInstance * hero) = 0;
+
+	/// Incremental search, used instead of initialize() if storage still holds results of previous search
+	/// for the same hero and hero moved along them (or did not move at all). Keeps valid part of the old tree,
+	/// see PathfinderUtil::rerootTree, and returns nodes search has to continue from.
+	/// Returns false if previous results can't be reused.
+	virtual bool reuseSearch(
+		const PathfinderOptions & options,
+		const CGameState * gs,
+		const CGHeroInstance * hero,
+		std::vector<CGPathNode *> & initialNodes)
+	{
+		return false;
+	}
 };
 
 class DLL_LINKAGE NodeStorage : public INodeStorage
@@ -407,14 +432,21 @@ private:
 public:
 	NodeStorage(CPathsInfo & pathsInfo, const CGHeroInstance * hero);
 
+	/// Returns nullptr if layer is not used by this pathfinder
 	STRONG_INLINE
 	CGPathNode * getNode(const int3 & coord, const EPathfindingLayer layer)
 	{
-		return out.getNode(coord, layer);
+		return out.hasLayer(layer) ? out.getNode(coord, layer) : nullptr;
 	}
 
 	void initialize(const PathfinderOptions & options, const CGameState * gs, const CGHeroInstance * hero) override;
 
+	bool reuseSearch(
+		const PathfinderOptions & options,
+		const CGameState * gs,
+		const CGHeroInstance * hero,
+		std::vector<CGPathNode *> & initialNodes) override;
+
 	virtual CGPathNode * getInitialNode() override;
 
 	virtual std::vector<CGPathNode *> calculateNeighbours(
@@ -469,7 +501,8 @@ private:
 	} patrolState;
 	std::unordered_set<int3, ShashInt3> patrolTiles;
 
-	boost::heap::fibonacci_heap<CGPathNode *, boost::heap::compare<NodeComparer<CGPathNode>> > pq;
+	CGPathNode::TPriorityQueue pq;
+	std::vector<CGPathNode *> initialNodes; //nodes kept from previous search to continue from, see INodeStorage::reuseSearch
 
 	PathNodeInfo source; //current (source) path node -> we took it from the queue
 	CDestinationNodeInfo destination; //destination node -> it's a neighbour of source that we consider
@@ -9,16 +9,11 @@
  */
 #pragma once
 
-#ifdef __FreeBSD__
-	#include <sys/types.h>
-	#include <sys/time.h>
-	#include <sys/resource.h>
-	#define TO_MS_DIVISOR (1000)
-#else
-	#include <ctime>
-	#define TO_MS_DIVISOR (CLOCKS_PER_SEC / 1000)
-#endif
+#include <chrono>
 
+#define TO_MS_DIVISOR (1000)
+
+/// Measures wall time, so work spread over several threads is not counted multiple times
 class CStopWatch
 {
 	si64 start, last, mem;
@@ -51,14 +46,8 @@ public:
 	}
 
 private:
-	si64 clock() 
+	si64 clock() //in microseconds
 	{
-	#ifdef __FreeBSD__
-		struct rusage usage;
-		getrusage(RUSAGE_SELF, &usage);
-		return static_cast<si64>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
-	#else
-		return std::clock();
-	#endif
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
 	}
 };
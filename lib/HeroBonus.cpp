@@ -197,9 +197,11 @@ int CTotalsProxy::getValue() const
 
 	if(treeVersion != valueCachedLast)
 	{
-		auto bonuses = getBonusList();
-
-		value = initialValue + bonuses->totalValue();
+		BonusList::Totals totals;
+		if(target->getIndexedTotals(totals, selector, Selector::all))
+			value = initialValue + totals.value();
+		else
+			value = initialValue + getBonusList()->totalValue();
 		valueCachedLast = treeVersion;
 	}
 	return value;
@@ -280,6 +282,74 @@ bool CCheckProxy::getHasBonus() const
 	return hasBonus;
 }
 
+BonusCacheKey::BonusCacheKey()
+	: id(0)
+{
+}
+
+BonusCacheKey::BonusCacheKey(EKind kind, int32_t field, int32_t info, int32_t value)
+{
+	//kind : 4 bits, type or source : 12 bits, additional info : 16 bits, subtype or source id : 32 bits
+	id = (static_cast<int64_t>(kind) << 60)
+		| (static_cast<int64_t>(field & 0xfff) << 48)
+		| (static_cast<int64_t>(info & 0xffff) << 32)
+		| static_cast<int64_t>(static_cast<uint32_t>(value));
+}
+
+BonusCacheKey BonusCacheKey::type(Bonus::BonusType type)
+{
+	return BonusCacheKey(TYPE, type, 0, 0);
+}
+
+BonusCacheKey BonusCacheKey::typeSubtype(Bonus::BonusType type, int32_t subtype)
+{
+	if(subtype == -1)
+		return BonusCacheKey::type(type);
+	return BonusCacheKey(TYPE_SUBTYPE, type, 0, subtype);
+}
+
+BonusCacheKey BonusCacheKey::typeSubtypeInfo(Bonus::BonusType type, int32_t subtype, int32_t info)
+{
+	return BonusCacheKey(TYPE_SUBTYPE_INFO, type, info, subtype);
+}
+
+BonusCacheKey BonusCacheKey::source(Bonus::BonusSource source, ui32 sourceID)
+{
+	return BonusCacheKey(SOURCE, source, 0, sourceID);
+}
+
+BonusCacheKey BonusCacheKey::named(const std::string & name)
+{
+	static boost::mutex mx;
+	static std::map<std::string, int32_t> names;
+
+	boost::mutex::scoped_lock lock(mx);
+	auto it = names.find(name);
+	if(it == names.end())
+		it = names.insert(std::make_pair(name, static_cast<int32_t>(names.size()))).first;
+	return BonusCacheKey(NAMED, 0, 0, it->second);
+}
+
+bool BonusCacheKey::empty() const
+{
+	return id == 0;
+}
+
+int64_t BonusCacheKey::getId() const
+{
+	return id;
+}
+
+bool BonusCacheKey::operator==(const BonusCacheKey & other) const
+{
+	return id == other.id;
+}
+
+bool BonusCacheKey::operator!=(const BonusCacheKey & other) const
+{
+	return id != other.id;
+}
+
 CAddInfo::CAddInfo()
 {
 }
@@ -341,43 +411,47 @@ JsonNode CAddInfo::toJsonNode() const
 }
 
 std::atomic<int32_t> CBonusSystemNode::treeChanged(1);
+std::atomic<int64_t> CBonusSystemNode::anyNodeChanged(1);
 const bool CBonusSystemNode::cachingEnabled = true;
 
-BonusList::BonusList(bool BelongsToTree) : belongsToTree(BelongsToTree)
+BonusList::BonusList()
 {
 
 }
 
 BonusList::BonusList(const BonusList &bonusList)
+	: typeIndex(bonusList.typeIndex),
+	typeOffsets(bonusList.typeOffsets),
+	typeTotalsNoLimit(bonusList.typeTotalsNoLimit),
+	typeTotalsAnyRange(bonusList.typeTotalsAnyRange)
 {
 	bonuses.resize(bonusList.size());
 	std::copy(bonusList.begin(), bonusList.end(), bonuses.begin());
-	belongsToTree = false;
 }
 
-BonusList::BonusList(BonusList&& other):
-	belongsToTree(false)
+BonusList::BonusList(BonusList&& other)
 {
-	std::swap(belongsToTree, other.belongsToTree);
 	std::swap(bonuses, other.bonuses);
+	std::swap(typeIndex, other.typeIndex);
+	std::swap(typeOffsets, other.typeOffsets);
+	std::swap(typeTotalsNoLimit, other.typeTotalsNoLimit);
+	std::swap(typeTotalsAnyRange, other.typeTotalsAnyRange);
 }
 
 BonusList& BonusList::operator=(const BonusList &bonusList)
 {
 	bonuses.resize(bonusList.size());
 	std::copy(bonusList.begin(), bonusList.end(), bonuses.begin());
-	belongsToTree = false;
+	typeIndex = bonusList.typeIndex;
+	typeOffsets = bonusList.typeOffsets;
+	typeTotalsNoLimit = bonusList.typeTotalsNoLimit;
+	typeTotalsAnyRange = bonusList.typeTotalsAnyRange;
 	return *this;
 }
 
-void BonusList::changed()
-{
-    if(belongsToTree)
-		CBonusSystemNode::treeHasChanged();
-}
-
 void BonusList::stackBonuses()
 {
+	dropTypeIndex();
 	boost::sort(bonuses, [](std::shared_ptr<Bonus> b1, std::shared_ptr<Bonus> b2) -> bool
 	{
 		if(b1 == b2)
@@ -415,59 +489,55 @@ void BonusList::stackBonuses()
 	}
 }
 
-int BonusList::totalValue() const
+void BonusList::Totals::add(const Bonus & b)
 {
-	int base = 0;
-	int percentToBase = 0;
-	int percentToAll = 0;
-	int additive = 0;
-	int indepMax = 0;
-	bool hasIndepMax = false;
-	int indepMin = 0;
-	bool hasIndepMin = false;
-
-	for(std::shared_ptr<Bonus> b : bonuses)
+	switch(b.valType)
 	{
-		switch(b->valType)
+	case Bonus::BASE_NUMBER:
+		base += b.val;
+		break;
+	case Bonus::PERCENT_TO_ALL:
+		percentToAll += b.val;
+		break;
+	case Bonus::PERCENT_TO_BASE:
+		percentToBase += b.val;
+		break;
+	case Bonus::ADDITIVE_VALUE:
+		additive += b.val;
+		break;
+	case Bonus::INDEPENDENT_MAX:
+		if (!hasIndepMax)
 		{
-		case Bonus::BASE_NUMBER:
-			base += b->val;
-			break;
-		case Bonus::PERCENT_TO_ALL:
-			percentToAll += b->val;
-			break;
-		case Bonus::PERCENT_TO_BASE:
-			percentToBase += b->val;
-			break;
-		case Bonus::ADDITIVE_VALUE:
-			additive += b->val;
-			break;
-		case Bonus::INDEPENDENT_MAX:
-			if (!hasIndepMax)
-			{
-				indepMax = b->val;
-				hasIndepMax = true;
-			}
-			else
-			{
-				vstd::amax(indepMax, b->val);
-			}
-
-			break;
-		case Bonus::INDEPENDENT_MIN:
-			if (!hasIndepMin)
-			{
-				indepMin = b->val;
-				hasIndepMin = true;
-			}
-			else
-			{
-				vstd::amin(indepMin, b->val);
-			}
+			indepMax = b.val;
+			hasIndepMax = true;
+		}
+		else
+		{
+			vstd::amax(indepMax, b.val);
+		}
 
-			break;
+		break;
+	case Bonus::INDEPENDENT_MIN:
+		if (!hasIndepMin)
+		{
+			indepMin = b.val;
+			hasIndepMin = true;
+		}
+		else
+		{
+			vstd::amin(indepMin, b.val);
 		}
+
+		break;
 	}
+
+	if(b.valType != Bonus::INDEPENDENT_MAX && b.valType != Bonus::INDEPENDENT_MIN)
+		notIndepBonuses++;
+	count++;
+}
+
+int BonusList::Totals::value() const
+{
 	int modifiedBase = base + (base * percentToBase) / 100;
 	modifiedBase += additive;
 	int valFirst = (modifiedBase * (100 + percentToAll)) / 100;
@@ -475,11 +545,6 @@ int BonusList::totalValue() const
 	if(hasIndepMin && hasIndepMax)
 		assert(indepMin < indepMax);
 
-	const int notIndepBonuses = (int)boost::count_if(bonuses, [](const std::shared_ptr<Bonus>& b)
-	{
-		return b->valType != Bonus::INDEPENDENT_MAX && b->valType != Bonus::INDEPENDENT_MIN;
-	});
-
 	if (hasIndepMax)
 	{
 		if(notIndepBonuses)
@@ -498,6 +563,14 @@ int BonusList::totalValue() const
 	return valFirst;
 }
 
+int BonusList::totalValue() const
+{
+	Totals totals;
+	for(auto & b : bonuses)
+		totals.add(*b);
+	return totals.value();
+}
+
 std::shared_ptr<Bonus> BonusList::getFirst(const CSelector &select)
 {
 	for (auto & b : bonuses)
@@ -525,14 +598,93 @@ void BonusList::getBonuses(BonusList & out, const CSelector &selector) const
 
 void BonusList::getBonuses(BonusList & out, const CSelector &selector, const CSelector &limit) const
 {
+	//add matching bonuses that matches limit predicate or have NO_LIMIT if no given predicate
+	auto matches = [&](const Bonus * b)
+	{
+		return selector(b) && ((!limit && b->effectRange == Bonus::NO_LIMIT) || ((bool)limit && limit(b)));
+	};
+
+	si32 type;
+	if(!typeOffsets.empty() && selector.getFixedField(CSelector::TYPE, type))
+	{
+		if(type < 0 || type + 1 >= static_cast<si32>(typeOffsets.size()))
+			return;
+
+		for(ui32 i = typeOffsets[type]; i < typeOffsets[type + 1]; i++)
+		{
+			auto & b = bonuses[typeIndex[i]];
+			if(matches(b.get()))
+				out.push_back(b);
+		}
+		return;
+	}
+
 	for (auto & b : bonuses)
 	{
-		//add matching bonuses that matches limit predicate or have NO_LIMIT if no given predicate
-		if(selector(b.get()) && ((!limit && b->effectRange == Bonus::NO_LIMIT) || ((bool)limit && limit(b.get()))))
+		if(matches(b.get()))
 			out.push_back(b);
 	}
 }
 
+void BonusList::indexByType()
+{
+	si32 maxType = -1;
+	for(auto & b : bonuses)
+		vstd::amax(maxType, static_cast<si32>(b->type));
+
+	//counting sort keeps original order of bonuses within each type
+	typeOffsets.assign(maxType + 2, 0);
+	for(auto & b : bonuses)
+		typeOffsets[b->type + 1]++;
+	for(size_t i = 1; i < typeOffsets.size(); i++)
+		typeOffsets[i] += typeOffsets[i - 1];
+
+	std::vector<ui32> next(typeOffsets.begin(), typeOffsets.end() - 1);
+	typeIndex.resize(bonuses.size());
+	for(ui32 i = 0; i < bonuses.size(); i++)
+		typeIndex[next[bonuses[i]->type]++] = i;
+
+	typeTotalsNoLimit.assign(maxType + 1, Totals());
+	typeTotalsAnyRange.assign(maxType + 1, Totals());
+	for(auto & b : bonuses)
+	{
+		if(b->effectRange == Bonus::NO_LIMIT)
+			typeTotalsNoLimit[b->type].add(*b);
+		typeTotalsAnyRange[b->type].add(*b);
+	}
+}
+
+bool BonusList::getIndexedTotals(Totals & out, const CSelector &selector, const CSelector &limit) const
+{
+	si32 type;
+	boost::optional<si32> subtype;
+
+	if(typeOffsets.empty() || !selector.isTypeQuery(type, subtype))
+		return false;
+
+	const bool anyRange = (bool)limit;
+	if(anyRange && !limit.selectsAll())
+		return false;
+
+	out = Totals();
+	if(type < 0 || type + 1 >= static_cast<si32>(typeOffsets.size()))
+		return true;
+
+	if(!subtype)
+	{
+		out = anyRange ? typeTotalsAnyRange[type] : typeTotalsNoLimit[type];
+		return true;
+	}
+
+	for(ui32 i = typeOffsets[type]; i < typeOffsets[type + 1]; i++)
+	{
+		const Bonus & b = *bonuses[typeIndex[i]];
+		if(b.subtype == *subtype && (anyRange || b.effectRange == Bonus::NO_LIMIT))
+			out.add(b);
+	}
+	return true;
+}
+
 void BonusList::getAllBonuses(BonusList &out) const
 {
 	for(auto & b : bonuses)
@@ -557,42 +709,42 @@ JsonNode BonusList::toJsonNode() const
 
 void BonusList::push_back(std::shared_ptr<Bonus> x)
 {
+	dropTypeIndex();
 	bonuses.push_back(x);
-	changed();
 }
 
 BonusList::TInternalContainer::iterator BonusList::erase(const int position)
 {
-	changed();
+	dropTypeIndex();
 	return bonuses.erase(bonuses.begin() + position);
 }
 
 void BonusList::clear()
 {
+	dropTypeIndex();
 	bonuses.clear();
-	changed();
 }
 
 std::vector<BonusList*>::size_type BonusList::operator-=(std::shared_ptr<Bonus> const &i)
 {
+	dropTypeIndex();
 	auto itr = std::find(bonuses.begin(), bonuses.end(), i);
 	if(itr == bonuses.end())
 		return false;
 	bonuses.erase(itr);
-	changed();
 	return true;
 }
 
 void BonusList::resize(BonusList::TInternalContainer::size_type sz, std::shared_ptr<Bonus> c )
 {
+	dropTypeIndex();
 	bonuses.resize(sz, c);
-	changed();
 }
 
 void BonusList::insert(BonusList::TInternalContainer::iterator position, BonusList::TInternalContainer::size_type n, std::shared_ptr<Bonus> const &x)
 {
+	dropTypeIndex();
 	bonuses.insert(position, n, x);
-	changed();
 }
 
 CSelector IBonusBearer::anaffectedByMoraleSelector
@@ -622,60 +774,68 @@ int IBonusBearer::valOfBonuses(Bonus::BonusType type, const CSelector &selector)
 
 int IBonusBearer::valOfBonuses(Bonus::BonusType type, int subtype) const
 {
-	boost::format fmt("type_%ds_%d");
-	fmt % (int)type % subtype;
-
 	CSelector s = Selector::type()(type);
 	if(subtype != -1)
 		s = s.And(Selector::subtype()(subtype));
 
-	return valOfBonuses(s, fmt.str());
+	return valOfBonuses(s, BonusCacheKey::typeSubtype(type, subtype));
 }
 
-int IBonusBearer::valOfBonuses(const CSelector &selector, const std::string &cachingStr) const
+bool IBonusBearer::getIndexedTotals(BonusList::Totals &out, const CSelector &selector, const CSelector &limit) const
+{
+	return false;
+}
+
+int IBonusBearer::valOfBonuses(const CSelector &selector, const BonusCacheKey &cachingKey) const
 {
 	CSelector limit = nullptr;
-	TConstBonusListPtr hlp = getAllBonuses(selector, limit, nullptr, cachingStr);
+	BonusList::Totals totals;
+	if(getIndexedTotals(totals, selector, limit))
+		return totals.value();
+
+	TConstBonusListPtr hlp = getAllBonuses(selector, limit, nullptr, cachingKey);
 	return hlp->totalValue();
 }
-bool IBonusBearer::hasBonus(const CSelector &selector, const std::string &cachingStr) const
+bool IBonusBearer::hasBonus(const CSelector &selector, const BonusCacheKey &cachingKey) const
 {
-	return getBonuses(selector, cachingStr)->size() > 0;
+	BonusList::Totals totals;
+	if(getIndexedTotals(totals, selector, nullptr))
+		return totals.count > 0;
+
+	return getBonuses(selector, cachingKey)->size() > 0;
 }
 
-bool IBonusBearer::hasBonus(const CSelector &selector, const CSelector &limit, const std::string &cachingStr) const
+bool IBonusBearer::hasBonus(const CSelector &selector, const CSelector &limit, const BonusCacheKey &cachingKey) const
 {
-	return getBonuses(selector, limit, cachingStr)->size() > 0;
+	BonusList::Totals totals;
+	if(getIndexedTotals(totals, selector, limit))
+		return totals.count > 0;
+
+	return getBonuses(selector, limit, cachingKey)->size() > 0;
 }
 
 bool IBonusBearer::hasBonusOfType(Bonus::BonusType type, int subtype) const
 {
-	boost::format fmt("type_%ds_%d");
-	fmt % (int)type % subtype;
-
 	CSelector s = Selector::type()(type);
 	if(subtype != -1)
 		s = s.And(Selector::subtype()(subtype));
 
-	return hasBonus(s, fmt.str());
+	return hasBonus(s, BonusCacheKey::typeSubtype(type, subtype));
 }
 
-TConstBonusListPtr IBonusBearer::getBonuses(const CSelector &selector, const std::string &cachingStr) const
+TConstBonusListPtr IBonusBearer::getBonuses(const CSelector &selector, const BonusCacheKey &cachingKey) const
 {
-	return getAllBonuses(selector, nullptr, nullptr, cachingStr);
+	return getAllBonuses(selector, nullptr, nullptr, cachingKey);
 }
 
-TConstBonusListPtr IBonusBearer::getBonuses(const CSelector &selector, const CSelector &limit, const std::string &cachingStr) const
+TConstBonusListPtr IBonusBearer::getBonuses(const CSelector &selector, const CSelector &limit, const BonusCacheKey &cachingKey) const
 {
-	return getAllBonuses(selector, limit, nullptr, cachingStr);
+	return getAllBonuses(selector, limit, nullptr, cachingKey);
 }
 
 bool IBonusBearer::hasBonusFrom(Bonus::BonusSource source, ui32 sourceID) const
 {
-	boost::format fmt("source_%did_%d");
-	fmt % (int)source % sourceID;
-
-	return hasBonus(Selector::source(source,sourceID), fmt.str());
+	return hasBonus(Selector::source(source,sourceID), BonusCacheKey::source(source, sourceID));
 }
 
 int IBonusBearer::MoraleVal() const
@@ -738,42 +898,42 @@ int IBonusBearer::LuckValAndBonusList(TConstBonusListPtr & bonusList) const
 
 ui32 IBonusBearer::MaxHealth() const
 {
-	const std::string cachingStr = "type_STACK_HEALTH";
+	static const auto cachingKey = BonusCacheKey::type(Bonus::STACK_HEALTH);
 	static const auto selector = Selector::type()(Bonus::STACK_HEALTH);
-	auto value = valOfBonuses(selector, cachingStr);
+	auto value = valOfBonuses(selector, cachingKey);
 	return std::max(1, value); //never 0
 }
 
 int IBonusBearer::getAttack(bool ranged) const
 {
-	const std::string cachingStr = "type_PRIMARY_SKILLs_ATTACK";
+	static const auto cachingKey = BonusCacheKey::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK);
 
 	static const auto selector = Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK);
 
-	return getBonuses(selector, nullptr, cachingStr)->totalValue();
+	return getBonuses(selector, nullptr, cachingKey)->totalValue();
 }
 
 int IBonusBearer::getDefense(bool ranged) const
 {
-	const std::string cachingStr = "type_PRIMARY_SKILLs_DEFENSE";
+	static const auto cachingKey = BonusCacheKey::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::DEFENSE);
 
 	static const auto selector = Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::DEFENSE);
 
-	return getBonuses(selector, nullptr, cachingStr)->totalValue();
+	return getBonuses(selector, nullptr, cachingKey)->totalValue();
 }
 
 int IBonusBearer::getMinDamage(bool ranged) const
 {
-	const std::string cachingStr = "type_CREATURE_DAMAGEs_0Otype_CREATURE_DAMAGEs_1";
+	static const auto cachingKey = BonusCacheKey::named("type_CREATURE_DAMAGEs_0Otype_CREATURE_DAMAGEs_1");
 	static const auto selector = Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 0).Or(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 1));
-	return valOfBonuses(selector, cachingStr);
+	return valOfBonuses(selector, cachingKey);
 }
 
 int IBonusBearer::getMaxDamage(bool ranged) const
 {
-	const std::string cachingStr = "type_CREATURE_DAMAGEs_0Otype_CREATURE_DAMAGEs_2";
+	static const auto cachingKey = BonusCacheKey::named("type_CREATURE_DAMAGEs_0Otype_CREATURE_DAMAGEs_2");
 	static const auto selector = Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 0).Or(Selector::typeSubtype(Bonus::CREATURE_DAMAGE, 2));
-	return valOfBonuses(selector, cachingStr);
+	return valOfBonuses(selector, cachingKey);
 }
 
 si32 IBonusBearer::manaLimit() const
@@ -786,7 +946,7 @@ si32 IBonusBearer::manaLimit() const
 int IBonusBearer::getPrimSkillLevel(PrimarySkill::PrimarySkill id) const
 {
 	static const CSelector selectorAllSkills = Selector::type()(Bonus::PRIMARY_SKILL);
-	static const std::string keyAllSkills = "type_PRIMARY_SKILL";
+	static const auto keyAllSkills = BonusCacheKey::type(Bonus::PRIMARY_SKILL);
 	auto allSkills = getBonuses(selectorAllSkills, keyAllSkills);
 	auto ret = allSkills->valOfBonuses(Selector::subtype()(id));
 	return ret; //sp=0 works in old saves
@@ -815,13 +975,13 @@ ui32 IBonusBearer::Speed(int turn, bool useBind) const
 
 bool IBonusBearer::isLiving() const //TODO: theoreticaly there exists "LIVING" bonus in stack experience documentation
 {
-	static const std::string cachingStr = "IBonusBearer::isLiving";
+	static const auto cachingKey = BonusCacheKey::named("IBonusBearer::isLiving");
 	static const CSelector selector = Selector::type()(Bonus::UNDEAD)
 		.Or(Selector::type()(Bonus::NON_LIVING))
 		.Or(Selector::type()(Bonus::GARGOYLE))
 		.Or(Selector::type()(Bonus::SIEGE_WEAPON));
 
-	return !hasBonus(selector, cachingStr);
+	return !hasBonus(selector, cachingKey);
 }
 
 std::shared_ptr<const Bonus> IBonusBearer::getBonus(const CSelector &selector) const
@@ -895,40 +1055,58 @@ void CBonusSystemNode::getAllBonusesRec(BonusList &out) const
 		out.push_back(update(b));
 }
 
-TConstBonusListPtr CBonusSystemNode::getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root, const std::string &cachingStr) const
+TConstBonusListPtr CBonusSystemNode::getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root, const BonusCacheKey &cachingKey) const
 {
 	bool limitOnUs = (!root || root == this); //caching won't work when we want to limit bonuses against an external node
 	if (CBonusSystemNode::cachingEnabled && limitOnUs)
 	{
-		// Exclusive access for one thread
-		static boost::mutex m;
-		boost::mutex::scoped_lock lock(m);
+		const auto treeVersion = getTreeVersion();
+		//results with and without limit differ, so store them under separate ids
+		const int64_t requestId = (bool)limit ? -cachingKey.getId() : cachingKey.getId();
 
-		// If the bonus system tree changes(state of a single node or the relations to each other) then
-		// cache all bonus objects. Selector objects doesn't matter.
-		if (cachedLast != treeChanged)
+		// Up to date cache can be read by many threads at once, each node has its own lock
+		// so queries on different nodes never wait for each other.
 		{
-			cachedBonuses.clear();
-			cachedRequests.clear();
+			boost::shared_lock<boost::shared_mutex> lock(cacheMutex);
 
-			BonusList allBonuses;
-			getAllBonusesRec(allBonuses);
-			limitBonuses(allBonuses, cachedBonuses);
-			cachedBonuses.stackBonuses();
-
-			cachedLast = treeChanged;
+			if(cachedLast == treeVersion)
+			{
+				if(!cachingKey.empty())
+				{
+					auto it = cachedRequests.find(requestId);
+					if(it != cachedRequests.end())
+					{
+						//Cached list contains bonuses for our query with applied limiters
+						cacheRequestHits.fetch_add(1, std::memory_order_relaxed);
+						return it->second;
+					}
+				}
+				else
+				{
+					auto ret = std::make_shared<BonusList>();
+					cachedBonuses.getBonuses(*ret, selector, limit);
+					return ret;
+				}
+			}
 		}
 
+		// Exclusive access for one thread, cache of this node is about to be modified
+		boost::unique_lock<boost::shared_mutex> lock(cacheMutex);
+
+		updateCachedBonuses(treeVersion);
+
 		// If a bonus system request comes with a caching string then look up in the map if there are any
 		// pre-calculated bonus results. Limiters can't be cached so they have to be calculated.
-		if (cachingStr != "")
+		if (!cachingKey.empty())
 		{
-			auto it = cachedRequests.find(cachingStr);
+			//another thread might have done the same query while we were waiting for the lock
+			auto it = cachedRequests.find(requestId);
 			if(it != cachedRequests.end())
 			{
-				//Cached list contains bonuses for our query with applied limiters
+				cacheRequestHits.fetch_add(1, std::memory_order_relaxed);
 				return it->second;
 			}
+			cacheRequestMisses.fetch_add(1, std::memory_order_relaxed);
 		}
 
 		//We still don't have the bonuses (didn't returned them from cache)
@@ -937,8 +1115,8 @@ TConstBonusListPtr CBonusSystemNode::getAllBonuses(const CSelector &selector, co
 		cachedBonuses.getBonuses(*ret, selector, limit);
 
 		// Save the results in the cache
-		if(cachingStr != "")
-			cachedRequests[cachingStr] = ret;
+		if(!cachingKey.empty())
+			cachedRequests[requestId] = ret;
 
 		return ret;
 	}
@@ -948,6 +1126,53 @@ TConstBonusListPtr CBonusSystemNode::getAllBonuses(const CSelector &selector, co
 	}
 }
 
+bool CBonusSystemNode::getIndexedTotals(BonusList::Totals &out, const CSelector &selector, const CSelector &limit) const
+{
+	if(!CBonusSystemNode::cachingEnabled)
+		return false;
+
+	const auto treeVersion = getTreeVersion();
+	{
+		boost::shared_lock<boost::shared_mutex> lock(cacheMutex);
+
+		if(cachedLast == treeVersion)
+		{
+			if(!cachedBonuses.getIndexedTotals(out, selector, limit))
+				return false;
+			cacheRequestHits.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	boost::unique_lock<boost::shared_mutex> lock(cacheMutex);
+	updateCachedBonuses(treeVersion);
+
+	if(!cachedBonuses.getIndexedTotals(out, selector, limit))
+		return false;
+	cacheRequestMisses.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+void CBonusSystemNode::updateCachedBonuses(int64_t treeVersion) const
+{
+	// If this node or any of its ancestors changed (state of a single node or the relations to each other) then
+	// cache all bonus objects. Selector objects doesn't matter.
+	if (cachedLast != treeVersion)
+	{
+		cachedBonuses.clear();
+		cachedRequests.clear();
+
+		BonusList allBonuses;
+		getAllBonusesRec(allBonuses);
+		limitBonuses(allBonuses, cachedBonuses);
+		cachedBonuses.stackBonuses();
+		cachedBonuses.indexByType();
+
+		cachedLast = treeVersion;
+		cacheRebuilds.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
 TConstBonusListPtr CBonusSystemNode::getAllBonusesWithoutCaching(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root) const
 {
 	auto ret = std::make_shared<BonusList>();
@@ -990,18 +1215,24 @@ std::shared_ptr<Bonus> CBonusSystemNode::update(const std::shared_ptr<Bonus> & b
 }
 
 CBonusSystemNode::CBonusSystemNode()
-	: bonuses(true),
-	exportedBonuses(true),
-	nodeType(UNKNOWN),
-	cachedLast(0)
+	: nodeType(UNKNOWN),
+	cachedLast(0),
+	nodeChanged(0),
+	lastChangeStamp(0),
+	cacheRequestHits(0),
+	cacheRequestMisses(0),
+	cacheRebuilds(0)
 {
 }
 
 CBonusSystemNode::CBonusSystemNode(ENodeTypes NodeType)
-	: bonuses(true),
-	exportedBonuses(true),
-	nodeType(NodeType),
-	cachedLast(0)
+	: nodeType(NodeType),
+	cachedLast(0),
+	nodeChanged(0),
+	lastChangeStamp(0),
+	cacheRequestHits(0),
+	cacheRequestMisses(0),
+	cacheRebuilds(0)
 {
 }
 
@@ -1010,7 +1241,12 @@ CBonusSystemNode::CBonusSystemNode(CBonusSystemNode && other):
 	exportedBonuses(std::move(other.exportedBonuses)),
 	nodeType(other.nodeType),
 	description(other.description),
-	cachedLast(0)
+	cachedLast(0),
+	nodeChanged(0),
+	lastChangeStamp(0),
+	cacheRequestHits(0),
+	cacheRequestMisses(0),
+	cacheRebuilds(0)
 {
 	std::swap(parents, other.parents);
 	std::swap(children, other.children);
@@ -1057,7 +1293,7 @@ void CBonusSystemNode::attachTo(CBonusSystemNode *parent)
 		newRedDescendant(parent);
 
 	parent->newChildAttached(this);
-	CBonusSystemNode::treeHasChanged();
+	nodeHasChanged();
 }
 
 void CBonusSystemNode::detachFrom(CBonusSystemNode *parent)
@@ -1071,7 +1307,7 @@ void CBonusSystemNode::detachFrom(CBonusSystemNode *parent)
 
 	parents -= parent;
 	parent->childDetached(this);
-	CBonusSystemNode::treeHasChanged();
+	nodeHasChanged();
 }
 
 void CBonusSystemNode::removeBonusesRecursive(const CSelector & s)
@@ -1107,14 +1343,19 @@ void CBonusSystemNode::addNewBonus(const std::shared_ptr<Bonus>& b)
 	assert(!vstd::contains(exportedBonuses, b));
 	exportedBonuses.push_back(b);
 	exportBonus(b);
-	CBonusSystemNode::treeHasChanged();
 }
 
 void CBonusSystemNode::accumulateBonus(const std::shared_ptr<Bonus>& b)
 {
 	auto bonus = exportedBonuses.getFirst(Selector::typeSubtype(b->type, b->subtype)); //only local bonuses are interesting //TODO: what about value type?
 	if(bonus)
+	{
 		bonus->val += b->val;
+		if(bonus->propagator) //we don't track where it was propagated to
+			CBonusSystemNode::treeHasChanged();
+		else
+			nodeHasChanged();
+	}
 	else
 		addNewBonus(std::make_shared<Bonus>(*b)); //duplicate needed, original may get destroyed
 }
@@ -1125,8 +1366,10 @@ void CBonusSystemNode::removeBonus(const std::shared_ptr<Bonus>& b)
 	if(b->propagator)
 		unpropagateBonus(b);
 	else
+	{
 		bonuses -= b;
-	CBonusSystemNode::treeHasChanged();
+		nodeHasChanged();
+	}
 }
 
 void CBonusSystemNode::removeBonuses(const CSelector & selector)
@@ -1155,6 +1398,7 @@ void CBonusSystemNode::propagateBonus(std::shared_ptr<Bonus> b)
 	if(b->propagator->shouldBeAttached(this))
 	{
 		bonuses.push_back(b);
+		nodeHasChanged();
 		logBonus->trace("#$# %s #propagated to# %s",  b->Description(), nodeName());
 	}
 
@@ -1167,6 +1411,7 @@ void CBonusSystemNode::unpropagateBonus(std::shared_ptr<Bonus> b)
 	if(b->propagator->shouldBeAttached(this))
 	{
 		bonuses -= b;
+		nodeHasChanged();
 		logBonus->trace("#$# %s #is no longer propagated to# %s",  b->Description(), nodeName());
 	}
 
@@ -1293,9 +1538,10 @@ void CBonusSystemNode::exportBonus(std::shared_ptr<Bonus> b)
 	if(b->propagator)
 		propagateBonus(b);
 	else
+	{
 		bonuses.push_back(b);
-
-	CBonusSystemNode::treeHasChanged();
+		nodeHasChanged();
+	}
 }
 
 void CBonusSystemNode::exportBonuses()
@@ -1394,12 +1640,52 @@ TBonusListPtr CBonusSystemNode::limitBonuses(const BonusList &allBonuses) const
 void CBonusSystemNode::treeHasChanged()
 {
 	treeChanged++;
+	anyNodeChanged++;
+}
+
+void CBonusSystemNode::nodeHasChanged()
+{
+	propagateChange(++anyNodeChanged);
+}
+
+void CBonusSystemNode::propagateChange(int64_t stamp)
+{
+	//node with several parents can be reached by more paths, it is enough to bump its version once
+	if(lastChangeStamp == stamp)
+		return;
+	lastChangeStamp = stamp;
+
+	//children inherit our bonuses, so their caches are outdated as well
+	nodeChanged++;
+	for(CBonusSystemNode * child : children)
+		child->propagateChange(stamp);
+}
+
+int64_t CBonusSystemNode::getGlobalTreeVersion()
+{
+	return anyNodeChanged;
+}
+
+CBonusSystemNode::CacheStatistics CBonusSystemNode::getCacheStatistics() const
+{
+	CacheStatistics ret;
+	ret.requestHits = cacheRequestHits;
+	ret.requestMisses = cacheRequestMisses;
+	ret.rebuilds = cacheRebuilds;
+	return ret;
+}
+
+void CBonusSystemNode::resetCacheStatistics()
+{
+	cacheRequestHits = 0;
+	cacheRequestMisses = 0;
+	cacheRebuilds = 0;
 }
 
 int64_t CBonusSystemNode::getTreeVersion() const
 {
 	int64_t ret = treeChanged;
-	return ret << 32;
+	return (ret << 32) + nodeChanged;
 }
 
 int NBonus::valOf(const CBonusSystemNode *obj, Bonus::BonusType type, int subtype)
@@ -1634,31 +1920,31 @@ namespace Selector
 {
 	DLL_LINKAGE CSelectFieldEqual<Bonus::BonusType> & type()
 	{
-		static CSelectFieldEqual<Bonus::BonusType> stype(&Bonus::type);
+		static CSelectFieldEqual<Bonus::BonusType> stype(&Bonus::type, CSelector::TYPE);
 		return stype;
 	}
 
 	DLL_LINKAGE CSelectFieldEqual<TBonusSubtype> & subtype()
 	{
-		static CSelectFieldEqual<TBonusSubtype> ssubtype(&Bonus::subtype);
+		static CSelectFieldEqual<TBonusSubtype> ssubtype(&Bonus::subtype, CSelector::SUBTYPE);
 		return ssubtype;
 	}
 
 	DLL_LINKAGE CSelectFieldEqual<CAddInfo> & info()
 	{
-		static CSelectFieldEqual<CAddInfo> sinfo(&Bonus::additionalInfo);
+		static CSelectFieldEqual<CAddInfo> sinfo(&Bonus::additionalInfo, CSelector::ADDITIONAL_INFO);
 		return sinfo;
 	}
 
 	DLL_LINKAGE CSelectFieldEqual<Bonus::BonusSource> & sourceType()
 	{
-		static CSelectFieldEqual<Bonus::BonusSource> ssourceType(&Bonus::source);
+		static CSelectFieldEqual<Bonus::BonusSource> ssourceType(&Bonus::source, CSelector::SOURCE);
 		return ssourceType;
 	}
 
 	DLL_LINKAGE CSelectFieldEqual<Bonus::LimitEffect> & effectRange()
 	{
-		static CSelectFieldEqual<Bonus::LimitEffect> seffectRange(&Bonus::effectRange);
+		static CSelectFieldEqual<Bonus::LimitEffect> seffectRange(&Bonus::effectRange, CSelector::EFFECT_RANGE);
 		return seffectRange;
 	}
 
@@ -1672,28 +1958,28 @@ namespace Selector
 
 	CSelector DLL_LINKAGE typeSubtypeInfo(Bonus::BonusType type, TBonusSubtype subtype, CAddInfo info)
 	{
-		return CSelectFieldEqual<Bonus::BonusType>(&Bonus::type)(type)
-			.And(CSelectFieldEqual<TBonusSubtype>(&Bonus::subtype)(subtype))
-			.And(CSelectFieldEqual<CAddInfo>(&Bonus::additionalInfo)(info));
+		return Selector::type()(type)
+			.And(Selector::subtype()(subtype))
+			.And(Selector::info()(info));
 	}
 
 	CSelector DLL_LINKAGE source(Bonus::BonusSource source, ui32 sourceID)
 	{
-		return CSelectFieldEqual<Bonus::BonusSource>(&Bonus::source)(source)
-			.And(CSelectFieldEqual<ui32>(&Bonus::sid)(sourceID));
+		return CSelector::fieldEqual(CSelector::SOURCE, source)
+			.And(CSelector::fieldEqual(CSelector::SOURCE_ID, sourceID));
 	}
 
 	CSelector DLL_LINKAGE sourceTypeSel(Bonus::BonusSource source)
 	{
-		return CSelectFieldEqual<Bonus::BonusSource>(&Bonus::source)(source);
+		return CSelector::fieldEqual(CSelector::SOURCE, source);
 	}
 
 	CSelector DLL_LINKAGE valueType(Bonus::ValueType valType)
 	{
-		return CSelectFieldEqual<Bonus::ValueType>(&Bonus::valType)(valType);
+		return CSelector::fieldEqual(CSelector::VALUE_TYPE, valType);
 	}
 
-	DLL_LINKAGE CSelector all([](const Bonus * b){return true;});
+	DLL_LINKAGE CSelector all(CSelector::matchAll());
 	DLL_LINKAGE CSelector none([](const Bonus * b){return false;});
 
 	bool DLL_LINKAGE matchesType(const CSelector &sel, Bonus::BonusType type)
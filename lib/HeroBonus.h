@@ -30,42 +30,141 @@ typedef std::set<CBonusSystemNode*> TNodes;
 typedef std::set<const CBonusSystemNode*> TCNodes;
 typedef std::vector<CBonusSystemNode *> TNodesVector;
 
-class CSelector : std::function<bool(const Bonus*)>
+class CSelector
 {
 	typedef std::function<bool(const Bonus*)> TBase;
 public:
-	CSelector() {}
+	//bonus fields that selector can test directly, without calling arbitrary predicate
+	enum EField : ui8
+	{
+		NO_FIELD, TYPE, SUBTYPE, SOURCE, SOURCE_ID, VALUE_TYPE, EFFECT_RANGE, ADDITIONAL_INFO
+	};
+
+	CSelector()
+		: testsCount(0), compiled(false)
+	{}
 	template<typename T>
 	CSelector(const T &t,	//SFINAE trick -> include this c-tor in overload resolution only if parameter is class
 							//(includes functors, lambdas) or function. Without that VC is going mad about ambiguities.
 		typename std::enable_if < boost::mpl::or_ < std::is_class<T>, std::is_function<T >> ::value>::type *dummy = nullptr)
-		: TBase(t)
+		: predicate(t), testsCount(0), compiled(false)
 	{}
 
 	CSelector(std::nullptr_t)
+		: testsCount(0), compiled(false)
 	{}
 
+	//selects bonuses which have given field equal to value
+	static CSelector fieldEqual(EField field, si32 value)
+	{
+		CSelector ret = matchAll();
+		ret.tests[ret.testsCount++] = FieldTest{value, field};
+		return ret;
+	}
+
+	//selects every bonus, And-ing other tests to it does not allocate
+	static CSelector matchAll()
+	{
+		CSelector ret;
+		ret.compiled = true;
+		return ret;
+	}
+
 	CSelector And(CSelector rhs) const
 	{
+		//conjunction of field tests stays flat as long as it fits
+		if(compiled && rhs.compiled && testsCount + rhs.testsCount <= MAX_TESTS)
+		{
+			CSelector ret = *this;
+			for(ui8 i = 0; i < rhs.testsCount; i++)
+				ret.tests[ret.testsCount++] = rhs.tests[i];
+			return ret;
+		}
 		//lambda may likely outlive "this" (it can be even a temporary) => we copy the OBJECT (not pointer)
 		auto thisCopy = *this;
 		return [thisCopy, rhs](const Bonus *b) mutable { return thisCopy(b) && rhs(b); };
 	}
 	CSelector Or(CSelector rhs) const
 	{
+		if(selectsAll())
+			return *this;
+		if(rhs.selectsAll())
+			return rhs;
 		auto thisCopy = *this;
 		return [thisCopy, rhs](const Bonus *b) mutable { return thisCopy(b) || rhs(b); };
 	}
 
-	bool operator()(const Bonus *b) const
+	inline bool operator()(const Bonus *b) const; //defined after Bonus
+
+	operator bool() const
 	{
-		return TBase::operator()(b);
+		return compiled || !!predicate;
 	}
 
-	operator bool() const
+	bool selectsAll() const
+	{
+		return compiled && testsCount == 0;
+	}
+
+	//true if selector tests only bonus type and optionally subtype
+	bool isTypeQuery(si32 & type, boost::optional<si32> & subtype) const
+	{
+		if(!compiled || testsCount == 0 || testsCount > 2)
+			return false;
+
+		bool hasType = false;
+		subtype.reset();
+		for(ui8 i = 0; i < testsCount; i++)
+		{
+			if(tests[i].field == TYPE && !hasType)
+			{
+				type = tests[i].value;
+				hasType = true;
+			}
+			else if(tests[i].field == SUBTYPE && !subtype)
+			{
+				subtype = tests[i].value;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return hasType;
+	}
+
+	//true if every selected bonus must have given field equal to value (which is then stored)
+	bool getFixedField(EField field, si32 & value) const
 	{
-		return !!static_cast<const TBase&>(*this);
+		if(compiled)
+		{
+			for(ui8 i = 0; i < testsCount; i++)
+			{
+				if(tests[i].field == field)
+				{
+					value = tests[i].value;
+					return true;
+				}
+			}
+		}
+		return false;
 	}
+
+private:
+	struct FieldTest
+	{
+		si32 value;
+		EField field;
+
+		inline bool matches(const Bonus * b) const; //defined after Bonus
+	};
+
+	static const ui8 MAX_TESTS = 4;
+
+	TBase predicate; //used only if selector is not compiled
+	std::array<FieldTest, MAX_TESTS> tests;
+	ui8 testsCount;
+	bool compiled; //selector is conjunction of tests
 };
 
 class DLL_LINKAGE CBonusProxy
@@ -526,15 +625,75 @@ struct DLL_LINKAGE Bonus : public std::enable_shared_from_this<Bonus>
 
 DLL_LINKAGE std::ostream & operator<<(std::ostream &out, const Bonus &bonus);
 
+inline bool CSelector::FieldTest::matches(const Bonus * b) const
+{
+	switch(field)
+	{
+	case TYPE:
+		return b->type == value;
+	case SUBTYPE:
+		return b->subtype == value;
+	case SOURCE:
+		return b->source == value;
+	case SOURCE_ID:
+		return b->sid == static_cast<ui32>(value);
+	case VALUE_TYPE:
+		return b->valType == value;
+	case EFFECT_RANGE:
+		return b->effectRange == value;
+	case ADDITIONAL_INFO:
+		return b->additionalInfo.size() == 1 && b->additionalInfo[0] == value;
+	default:
+		return false;
+	}
+}
+
+inline bool CSelector::operator()(const Bonus * b) const
+{
+	if(!compiled)
+		return predicate(b);
+
+	for(ui8 i = 0; i < testsCount; i++)
+	{
+		if(!tests[i].matches(b))
+			return false;
+	}
+	return true;
+}
+
 class DLL_LINKAGE BonusList
 {
 public:
 	typedef std::vector<std::shared_ptr<Bonus>> TInternalContainer;
 
+	//bonus values summed per value type, enough to compute total value
+	struct DLL_LINKAGE Totals
+	{
+		int base = 0;
+		int percentToBase = 0;
+		int percentToAll = 0;
+		int additive = 0;
+		int indepMax = 0;
+		bool hasIndepMax = false;
+		int indepMin = 0;
+		bool hasIndepMin = false;
+		int notIndepBonuses = 0;
+		int count = 0;
+
+		void add(const Bonus & b);
+		int value() const;
+	};
+
 private:
 	TInternalContainer bonuses;
-	bool belongsToTree;
-	void changed();
+	//positions of bonuses grouped by type, bonuses of type T are at typeIndex[typeOffsets[T]..typeOffsets[T+1])
+	std::vector<ui32> typeIndex;
+	std::vector<ui32> typeOffsets; //empty if there is no valid index
+	//totals of each type for bonuses without limit and for bonuses with any effect range
+	std::vector<Totals> typeTotalsNoLimit;
+	std::vector<Totals> typeTotalsAnyRange;
+
+	void dropTypeIndex() { typeOffsets.clear(); }
 
 public:
 	typedef TInternalContainer::const_reference const_reference;
@@ -543,7 +702,7 @@ public:
 	typedef TInternalContainer::const_iterator const_iterator;
 	typedef TInternalContainer::iterator iterator;
 
-	BonusList(bool BelongsToTree = false);
+	BonusList();
 	BonusList(const BonusList &bonusList);
 	BonusList(BonusList && other);
 	BonusList& operator=(const BonusList &bonusList);
@@ -555,10 +714,10 @@ public:
 	void clear();
 	bool empty() const { return bonuses.empty(); }
 	void resize(TInternalContainer::size_type sz, std::shared_ptr<Bonus> c = nullptr );
-	STRONG_INLINE std::shared_ptr<Bonus> &operator[] (TInternalContainer::size_type n) { return bonuses[n]; }
+	STRONG_INLINE std::shared_ptr<Bonus> &operator[] (TInternalContainer::size_type n) { dropTypeIndex(); return bonuses[n]; }
 	STRONG_INLINE const std::shared_ptr<Bonus> &operator[] (TInternalContainer::size_type n) const { return bonuses[n]; }
-	std::shared_ptr<Bonus> &back() { return bonuses.back(); }
-	std::shared_ptr<Bonus> &front() { return bonuses.front(); }
+	std::shared_ptr<Bonus> &back() { dropTypeIndex(); return bonuses.back(); }
+	std::shared_ptr<Bonus> &front() { dropTypeIndex(); return bonuses.front(); }
 	const std::shared_ptr<Bonus> &back() const { return bonuses.back(); }
 	const std::shared_ptr<Bonus> &front() const { return bonuses.front(); }
 
@@ -575,6 +734,12 @@ public:
 
 	void getBonuses(BonusList & out, const CSelector &selector) const;
 
+	//lets getBonuses visit only bonuses of selected type, index is valid until list is modified
+	void indexByType();
+	//totals of getBonuses(selector, limit) if they can be taken from type index without building list
+	//works for type (and subtype) selectors with no limit or Selector::all
+	bool getIndexedTotals(Totals & out, const CSelector &selector, const CSelector &limit) const;
+
 	//special find functions
 	std::shared_ptr<Bonus> getFirst(const CSelector &select);
 	std::shared_ptr<const Bonus> getFirst(const CSelector &select) const;
@@ -587,6 +752,7 @@ public:
 	template <class Predicate>
 	void remove_if(Predicate pred)
 	{
+		dropTypeIndex();
 		BonusList newList;
 		for (ui32 i = 0; i < bonuses.size(); i++)
 		{
@@ -606,17 +772,20 @@ public:
 	template <typename Handler>
 	void serialize(Handler &h, const int version)
 	{
+		dropTypeIndex();
 		h & static_cast<TInternalContainer&>(bonuses);
 	}
 
 	// C++ for range support
 	auto begin () -> decltype (bonuses.begin())
 	{
+		dropTypeIndex();
 		return bonuses.begin();
 	}
 
 	auto end () -> decltype (bonuses.end())
 	{
+		dropTypeIndex();
 		return bonuses.end();
 	}
 };
@@ -669,6 +838,33 @@ public:
 	}
 };
 
+/// Identifies result of bonus query in node cache, it has to be unique for each combination of selector and limit.
+/// Keys of simple queries are encoded directly, other queries are interned once by name.
+class DLL_LINKAGE BonusCacheKey
+{
+public:
+	BonusCacheKey(); //query is not cached
+
+	static BonusCacheKey type(Bonus::BonusType type);
+	static BonusCacheKey typeSubtype(Bonus::BonusType type, int32_t subtype); //subtype -1 means type only
+	static BonusCacheKey typeSubtypeInfo(Bonus::BonusType type, int32_t subtype, int32_t info);
+	static BonusCacheKey source(Bonus::BonusSource source, ui32 sourceID);
+	static BonusCacheKey named(const std::string & name); //slow, result should be stored in static variable
+
+	bool empty() const;
+	int64_t getId() const;
+
+	bool operator==(const BonusCacheKey & other) const;
+	bool operator!=(const BonusCacheKey & other) const;
+
+private:
+	enum EKind {NONE, TYPE, TYPE_SUBTYPE, TYPE_SUBTYPE_INFO, SOURCE, NAMED};
+
+	BonusCacheKey(EKind kind, int32_t field, int32_t info, int32_t value);
+
+	int64_t id;
+};
+
 class DLL_LINKAGE IBonusBearer
 {
 private:
@@ -689,12 +885,14 @@ public:
 	// * root is node on which call was made (nullptr will be replaced with this)
 	//interface
 	IBonusBearer();
-	virtual TConstBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const std::string &cachingStr = "") const = 0;
-	int valOfBonuses(const CSelector &selector, const std::string &cachingStr = "") const;
-	bool hasBonus(const CSelector &selector, const std::string &cachingStr = "") const;
-	bool hasBonus(const CSelector &selector, const CSelector &limit, const std::string &cachingStr = "") const;
-	TConstBonusListPtr getBonuses(const CSelector &selector, const CSelector &limit, const std::string &cachingStr = "") const;
-	TConstBonusListPtr getBonuses(const CSelector &selector, const std::string &cachingStr = "") const;
+	virtual TConstBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const BonusCacheKey &cachingKey = BonusCacheKey()) const = 0;
+	//totals of getAllBonuses(selector, limit) if they are available without building bonus list, false otherwise
+	virtual bool getIndexedTotals(BonusList::Totals &out, const CSelector &selector, const CSelector &limit) const;
+	int valOfBonuses(const CSelector &selector, const BonusCacheKey &cachingKey = BonusCacheKey()) const;
+	bool hasBonus(const CSelector &selector, const BonusCacheKey &cachingKey = BonusCacheKey()) const;
+	bool hasBonus(const CSelector &selector, const CSelector &limit, const BonusCacheKey &cachingKey = BonusCacheKey()) const;
+	TConstBonusListPtr getBonuses(const CSelector &selector, const CSelector &limit, const BonusCacheKey &cachingKey = BonusCacheKey()) const;
+	TConstBonusListPtr getBonuses(const CSelector &selector, const BonusCacheKey &cachingKey = BonusCacheKey()) const;
 
 	std::shared_ptr<const Bonus> getBonus(const CSelector &selector) const; //returns any bonus visible on node that matches (or nullptr if none matches)
 
@@ -753,19 +951,28 @@ private:
 	std::string description;
 
 	static const bool cachingEnabled;
+	mutable boost::shared_mutex cacheMutex; //guards cachedBonuses, cachedLast and cachedRequests
 	mutable BonusList cachedBonuses;
 	mutable int64_t cachedLast;
 	static std::atomic<int32_t> treeChanged;
+	static std::atomic<int64_t> anyNodeChanged; //bumped on every change anywhere, also stamps change propagation
+	std::atomic<int32_t> nodeChanged; //local part of tree version, bumped when this node or any of its ancestors changes
+	int64_t lastChangeStamp; //last propagation that reached this node, so nodes with several parents are visited once
 
-	// Setting a value to cachingStr before getting any bonuses caches the result for later requests.
-	// This string needs to be unique, that's why it has to be setted in the following manner:
-	// [property key]_[value] => only for selector
-	mutable std::map<std::string, TBonusListPtr > cachedRequests;
+	mutable std::atomic<int64_t> cacheRequestHits;
+	mutable std::atomic<int64_t> cacheRequestMisses;
+	mutable std::atomic<int64_t> cacheRebuilds;
+
+	// Setting a cachingKey before getting any bonuses caches the result for later requests.
+	// Results of queries with and without limit are stored separately even if they use the same key.
+	mutable std::unordered_map<int64_t, TBonusListPtr> cachedRequests;
 
 	void getBonusesRec(BonusList &out, const CSelector &selector, const CSelector &limit) const;
 	void getAllBonusesRec(BonusList &out) const;
 	TConstBonusListPtr getAllBonusesWithoutCaching(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr) const;
+	void updateCachedBonuses(int64_t treeVersion) const; //requires exclusive lock on cacheMutex
 	std::shared_ptr<Bonus> update(const std::shared_ptr<Bonus> & b) const;
+	void propagateChange(int64_t stamp);
 
 public:
 	explicit CBonusSystemNode();
@@ -775,7 +982,8 @@ public:
 
 	void limitBonuses(const BonusList &allBonuses, BonusList &out) const; //out will bo populed with bonuses that are not limited here
 	TBonusListPtr limitBonuses(const BonusList &allBonuses) const; //same as above, returns out by val for convienence
-	TConstBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const std::string &cachingStr = "") const override;
+	TConstBonusListPtr getAllBonuses(const CSelector &selector, const CSelector &limit, const CBonusSystemNode *root = nullptr, const BonusCacheKey &cachingKey = BonusCacheKey()) const override;
+	bool getIndexedTotals(BonusList::Totals &out, const CSelector &selector, const CSelector &limit) const override;
 	void getParents(TCNodes &out) const;  //retrieves list of parent nodes (nodes to inherit bonuses from),
 	std::shared_ptr<const Bonus> getBonusLocalFirst(const CSelector &selector) const;
 
@@ -824,7 +1032,19 @@ public:
 	const std::string &getDescription() const;
 	void setDescription(const std::string &description);
 
-	static void treeHasChanged();
+	struct CacheStatistics
+	{
+		int64_t requestHits;
+		int64_t requestMisses;
+		int64_t rebuilds;
+	};
+
+	static void treeHasChanged(); //invalidates caches of all nodes, use when affected part of tree is not known
+	void nodeHasChanged(); //invalidates caches of this node and all nodes that inherit bonuses from it
+	static int64_t getGlobalTreeVersion(); //changes with any change in any tree, for bearers combining bonuses of unrelated nodes
+
+	CacheStatistics getCacheStatistics() const; //statistics of cached queries made on this node
+	void resetCacheStatistics();
 
 	int64_t getTreeVersion() const override;
 
@@ -879,15 +1099,34 @@ template<typename T>
 class CSelectFieldEqual
 {
 	T Bonus::*ptr;
+	CSelector::EField field;
+
+	static bool toFieldValue(si32 value, si32 & out)
+	{
+		out = value;
+		return true;
+	}
+
+	static bool toFieldValue(const CAddInfo & value, si32 & out)
+	{
+		if(value.size() != 1)
+			return false;
+		out = value[0];
+		return true;
+	}
 
 public:
-	CSelectFieldEqual(T Bonus::*Ptr)
-		: ptr(Ptr)
+	CSelectFieldEqual(T Bonus::*Ptr, CSelector::EField Field = CSelector::NO_FIELD)
+		: ptr(Ptr), field(Field)
 	{
 	}
 
 	CSelector operator()(const T &valueToCompareAgainst) const
 	{
+		si32 value;
+		if(field != CSelector::NO_FIELD && toFieldValue(valueToCompareAgainst, value))
+			return CSelector::fieldEqual(field, value);
+
 		auto ptr2 = ptr; //We need a COPY because we don't want to reference this (might be outlived by lambda)
 		return [ptr2, valueToCompareAgainst](const Bonus *bonus)
 		{
@@ -1179,12 +1418,11 @@ extern DLL_LINKAGE const std::map<std::string, TLimiterPtr> bonusLimiterMap;
 extern DLL_LINKAGE const std::map<std::string, TPropagatorPtr> bonusPropagatorMap;
 extern DLL_LINKAGE const std::map<std::string, TUpdaterPtr> bonusUpdaterMap;
 
-// BonusList template that requires full interface of CBonusSystemNode
 template <class InputIterator>
 void BonusList::insert(const int position, InputIterator first, InputIterator last)
 {
+	dropTypeIndex();
 	bonuses.insert(bonuses.begin() + position, first, last);
-	changed();
 }
 
 // observers for updating bonuses based on certain events (e.g. hero gaining level)
@@ -319,13 +319,10 @@ bool JsonParser::extractString(std::string &str)
 
 bool JsonParser::extractString(JsonNode &node)
 {
-	std::string str;
-	if (!extractString(str))
-		return false;
-
-	node.setType(JsonNode::JsonType::DATA_STRING);
-	node.String() = str;
-	return true;
+	//string is extracted directly into node
+	std::string & str = node.String();
+	str.clear();
+	return extractString(str);
 }
 
 bool JsonParser::extractLiteral(const std::string &literal)
@@ -395,28 +392,33 @@ bool JsonParser::extractStruct(JsonNode &node)
 
 		// split key string into actual key and meta-flags
 		std::vector<std::string> keyAndFlags;
-		boost::split(keyAndFlags, key, boost::is_any_of("#"));
-		key = keyAndFlags[0];
-		// check for unknown flags - helps with debugging
-		std::vector<std::string> knownFlags = { "override" };
-		for(int i = 1; i < keyAndFlags.size(); i++)
+		if (key.find('#') != std::string::npos)
 		{
-			if(!vstd::contains(knownFlags, keyAndFlags[i]))
-				error("Encountered unknown flag #" + keyAndFlags[i], true);
+			boost::split(keyAndFlags, key, boost::is_any_of("#"));
+			key = keyAndFlags[0];
+			// check for unknown flags - helps with debugging
+			static const std::vector<std::string> knownFlags = { "override" };
+			for(int i = 1; i < keyAndFlags.size(); i++)
+			{
+				if(!vstd::contains(knownFlags, keyAndFlags[i]))
+					error("Encountered unknown flag #" + keyAndFlags[i], true);
+			}
 		}
 
-		if (node.Struct().find(key) != node.Struct().end())
+		auto inserted = node.Struct().insert(std::make_pair(std::move(key), JsonNode()));
+		if (!inserted.second)
 			error("Dublicated element encountered!", true);
+		JsonNode & element = inserted.first->second;
 
 		if (!extractSeparator())
 			return false;
 
-		if (!extractElement(node.Struct()[key], '}'))
+		if (!extractElement(element, '}'))
 			return false;
 
 		// flags from key string belong to referenced element
 		for(int i = 1; i < keyAndFlags.size(); i++)
-			node.Struct()[key].flags.push_back(keyAndFlags[i]);
+			element.flags.push_back(keyAndFlags[i]);
 
 		if (input[pos] == '}')
 		{
@@ -443,9 +445,8 @@ bool JsonParser::extractArray(JsonNode &node)
 
 	while (true)
 	{
-		//NOTE: currently 50% of time is this vector resizing.
-		//May be useful to use list during parsing and then swap() all items to vector
-		node.Vector().resize(node.Vector().size()+1);
+		//nodes are moved when vector grows, so children are not copied
+		node.Vector().push_back(JsonNode());
 
 		if (!extractElement(node.Vector().back(), ']'))
 			return false;
@@ -44,27 +44,27 @@ JsonNode::JsonNode(const char *data, size_t datasize):
 JsonNode::JsonNode(ResourceID && fileURI):
 	type(JsonType::DATA_NULL)
 {
-	auto file = CResourceHandler::get()->load(fileURI)->readAll();
+	auto file = CResourceHandler::get()->load(fileURI)->readShared();
 
-	JsonParser parser(reinterpret_cast<char*>(file.first.get()), file.second);
+	JsonParser parser(reinterpret_cast<const char*>(file.first.get()), file.second);
 	*this = parser.parse(fileURI.getName());
 }
 
 JsonNode::JsonNode(const ResourceID & fileURI):
 	type(JsonType::DATA_NULL)
 {
-	auto file = CResourceHandler::get()->load(fileURI)->readAll();
+	auto file = CResourceHandler::get()->load(fileURI)->readShared();
 
-	JsonParser parser(reinterpret_cast<char*>(file.first.get()), file.second);
+	JsonParser parser(reinterpret_cast<const char*>(file.first.get()), file.second);
 	*this = parser.parse(fileURI.getName());
 }
 
 JsonNode::JsonNode(ResourceID && fileURI, bool &isValidSyntax):
 	type(JsonType::DATA_NULL)
 {
-	auto file = CResourceHandler::get()->load(fileURI)->readAll();
+	auto file = CResourceHandler::get()->load(fileURI)->readShared();
 
-	JsonParser parser(reinterpret_cast<char*>(file.first.get()), file.second);
+	JsonParser parser(reinterpret_cast<const char*>(file.first.get()), file.second);
 	*this = parser.parse(fileURI.getName());
 	isValidSyntax = parser.isValid();
 }
@@ -87,6 +87,15 @@ JsonNode::JsonNode(const JsonNode &copy):
 	}
 }
 
+JsonNode::JsonNode(JsonNode &&other) noexcept:
+	type(other.type),
+	data(other.data),
+	meta(std::move(other.meta)),
+	flags(std::move(other.flags))
+{
+	other.type = JsonType::DATA_NULL;
+}
+
 JsonNode::~JsonNode()
 {
 	setType(JsonType::DATA_NULL);
@@ -135,7 +144,7 @@ JsonNode::JsonType JsonNode::getType() const
 	return type;
 }
 
-void JsonNode::setMeta(std::string metadata, bool recursive)
+void JsonNode::setMeta(const std::string & metadata, bool recursive)
 {
 	meta = metadata;
 	if (recursive)
@@ -224,7 +233,7 @@ bool JsonNode::containsBaseData() const
 	case JsonType::DATA_NULL:
 		return false;
 	case JsonType::DATA_STRUCT:
-		for(auto elem : *data.Struct)
+		for(const auto & elem : *data.Struct)
 		{
 			if(elem.second.containsBaseData())
 				return true;
@@ -384,12 +393,12 @@ const JsonMap & JsonNode::Struct() const
 	return *data.Struct;
 }
 
-JsonNode & JsonNode::operator[](std::string child)
+JsonNode & JsonNode::operator[](const std::string & child)
 {
 	return Struct()[child];
 }
 
-const JsonNode & JsonNode::operator[](std::string child) const
+const JsonNode & JsonNode::operator[](const std::string & child) const
 {
 	auto it = Struct().find(child);
 	if (it != Struct().end())
@@ -955,6 +964,9 @@ const JsonNode & getSchemaByName(std::string name)
 {
 	// cached schemas to avoid loading json data multiple times
 	static std::map<std::string, JsonNode> loadedSchemas;
+	// mods are validated concurrently, references to map elements remain valid after unlocking
+	static boost::mutex loadedSchemasMutex;
+	boost::unique_lock<boost::mutex> lock(loadedSchemasMutex);
 
 	if (vstd::contains(loadedSchemas, name))
 		return loadedSchemas[name];
@@ -1003,7 +1015,7 @@ void JsonUtils::merge(JsonNode & dest, JsonNode & source, bool noOverride)
 {
 	if (dest.getType() == JsonNode::JsonType::DATA_NULL)
 	{
-		std::swap(dest, source);
+		dest.swap(source);
 		return;
 	}
 
@@ -1020,14 +1032,14 @@ void JsonUtils::merge(JsonNode & dest, JsonNode & source, bool noOverride)
 		case JsonNode::JsonType::DATA_STRING:
 		case JsonNode::JsonType::DATA_VECTOR:
 		{
-			std::swap(dest, source);
+			dest.swap(source);
 			break;
 		}
 		case JsonNode::JsonType::DATA_STRUCT:
 		{
 			if(!noOverride && vstd::contains(source.flags, "override"))
 			{
-				std::swap(dest, source);
+				dest.swap(source);
 			}
 			else
 			{
@@ -63,6 +63,8 @@ public:
 	explicit JsonNode(ResourceID && fileURI, bool & isValidSyntax);
 	//Copy c-tor
 	JsonNode(const JsonNode &copy);
+	//Move c-tor, leaves source as null node. Allows containers of nodes to grow without deep copies
+	JsonNode(JsonNode &&other) noexcept;
 
 	~JsonNode();
 
@@ -72,7 +74,7 @@ public:
 	bool operator == (const JsonNode &other) const;
 	bool operator != (const JsonNode &other) const;
 
-	void setMeta(std::string metadata, bool recursive = true);
+	void setMeta(const std::string & metadata, bool recursive = true);
 
 	/// Convert node to another type. Converting to nullptr will clear all data
 	void setType(JsonType Type);
@@ -119,8 +121,8 @@ public:
 	Type convertTo() const;
 
 	//operator [], for structs only - get child node by name
-	JsonNode & operator[](std::string child);
-	const JsonNode & operator[](std::string child) const;
+	JsonNode & operator[](const std::string & child);
+	const JsonNode & operator[](const std::string & child) const;
 
 	std::string toJson(bool compact = false) const;
 
@@ -1334,7 +1334,10 @@ DLL_LINKAGE void BattleTriggerEffect::applyGs(CGameState *gs)
 		auto b = st->getBonusLocalFirst(Selector::source(Bonus::SPELL_EFFECT, SpellID::POISON)
 				.And(Selector::type()(Bonus::STACK_HEALTH)));
 		if (b)
+		{
 			b->val = val;
+			st->nodeHasChanged();
+		}
 		break;
 	}
 	case Bonus::ENCHANTER:
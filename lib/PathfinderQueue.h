@@ -0,0 +1,296 @@
+/*
+ * PathfinderQueue.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include <cstring>
+
+/// Open list implementations for CPathfinder, chosen at compile time:
+/// * default - indexed heap in a single vector, arity is set by VCMI_PATHFINDER_HEAP_ARITY (4 if not defined)
+/// * VCMI_PATHFINDER_RADIX_QUEUE - radix queue over bits of node cost, costs popped never decrease in Dijkstra
+///
+/// Queue requires from node type:
+/// * float getCost() const
+/// * ui32 pqIndex - position of node inside of queue, owned by queue while node is queued
+/// Node notifies queue with update(node, oldCost) after its cost has changed.
+
+#ifndef VCMI_PATHFINDER_HEAP_ARITY
+	#define VCMI_PATHFINDER_HEAP_ARITY 4
+#endif
+
+template<typename N, int Arity>
+class IndexedNodeHeap
+{
+	static_assert(Arity >= 2, "Heap needs at least two children per node");
+
+	std::vector<N *> heap;
+
+public:
+	void reserve(size_t size)
+	{
+		heap.reserve(size);
+	}
+
+	bool empty() const
+	{
+		return heap.empty();
+	}
+
+	void clear()
+	{
+		heap.clear();
+	}
+
+	void push(N * node)
+	{
+		node->pqIndex = static_cast<ui32>(heap.size());
+		heap.push_back(node);
+		siftUp(node->pqIndex);
+	}
+
+	N * top() const
+	{
+		return heap.front();
+	}
+
+	void pop()
+	{
+		N * last = heap.back();
+		heap.pop_back();
+
+		if(!heap.empty())
+		{
+			heap[0] = last;
+			last->pqIndex = 0;
+			siftDown(0);
+		}
+	}
+
+	void update(N * node, float oldCost)
+	{
+		if(node->getCost() < oldCost)
+			siftUp(node->pqIndex);
+		else
+			siftDown(node->pqIndex);
+	}
+
+private:
+	STRONG_INLINE
+	void place(N * node, ui32 index)
+	{
+		heap[index] = node;
+		node->pqIndex = index;
+	}
+
+	void siftUp(ui32 index)
+	{
+		N * node = heap[index];
+		const float cost = node->getCost();
+
+		while(index > 0)
+		{
+			ui32 parent = (index - 1) / Arity;
+			if(heap[parent]->getCost() <= cost)
+				break;
+
+			place(heap[parent], index);
+			index = parent;
+		}
+		place(node, index);
+	}
+
+	void siftDown(ui32 index)
+	{
+		N * node = heap[index];
+		const float cost = node->getCost();
+		const ui32 size = static_cast<ui32>(heap.size());
+
+		while(true)
+		{
+			ui32 first = index * Arity + 1;
+			if(first >= size)
+				break;
+
+			ui32 best = first;
+			ui32 last = std::min(first + Arity, size);
+			for(ui32 child = first + 1; child < last; child++)
+			{
+				if(heap[child]->getCost() < heap[best]->getCost())
+					best = child;
+			}
+
+			if(heap[best]->getCost() >= cost)
+				break;
+
+			place(heap[best], index);
+			index = best;
+		}
+		place(node, index);
+	}
+};
+
+/// Buckets are selected by highest bit in which node cost differs from last popped cost.
+/// Non-negative floats compare the same as their bit patterns, so cost (turns + fraction of turn)
+/// is used as radix key directly and each bucket covers doubled range of previous one.
+template<typename N>
+class RadixNodeQueue
+{
+	static const int BUCKETS = 33;
+	static const ui32 POSITION_BITS = 26;
+	static const ui32 POSITION_MASK = (1u << POSITION_BITS) - 1;
+
+	std::array<std::vector<N *>, BUCKETS> buckets;
+	ui32 lastKey;
+	size_t count;
+	size_t belowLast; //nodes in bucket 0 cheaper than last popped one, only if caller broke monotonicity
+
+public:
+	RadixNodeQueue()
+		: lastKey(0), count(0), belowLast(0)
+	{
+	}
+
+	void reserve(size_t size)
+	{
+		buckets[0].reserve(size / 4);
+	}
+
+	bool empty() const
+	{
+		return count == 0;
+	}
+
+	void clear()
+	{
+		for(auto & bucket : buckets)
+			bucket.clear();
+		lastKey = 0;
+		count = 0;
+		belowLast = 0;
+	}
+
+	void push(N * node)
+	{
+		insert(node, keyOf(node->getCost()));
+		count++;
+	}
+
+	N * top()
+	{
+		if(buckets[0].empty())
+			redistribute();
+
+		//bucket 0 holds nodes with cost equal to last popped cost, any of them is minimal
+		auto & bucket = buckets[0];
+		if(!belowLast)
+			return bucket.back();
+
+		N * best = bucket.front();
+		for(N * node : bucket)
+		{
+			if(node->getCost() < best->getCost())
+				best = node;
+		}
+		return best;
+	}
+
+	void pop()
+	{
+		N * node = top();
+		remove(node, keyOf(node->getCost()));
+		count--;
+	}
+
+	void update(N * node, float oldCost)
+	{
+		remove(node, keyOf(oldCost));
+		insert(node, keyOf(node->getCost()));
+	}
+
+private:
+	static ui32 keyOf(float cost)
+	{
+		ui32 key;
+		std::memcpy(&key, &cost, sizeof(key));
+		return cost > 0 ? key : 0;
+	}
+
+	int bucketOf(ui32 key) const
+	{
+		if(key <= lastKey)
+			return 0;
+
+		int bucket = 0;
+		for(ui32 diff = key ^ lastKey; diff; diff >>= 1)
+			bucket++;
+		return bucket;
+	}
+
+	STRONG_INLINE
+	void setIndex(N * node, ui32 bucket, ui32 position)
+	{
+		node->pqIndex = (bucket << POSITION_BITS) | position;
+	}
+
+	void insert(N * node, ui32 key)
+	{
+		ui32 bucket = bucketOf(key);
+		auto & nodes = buckets[bucket];
+		assert(nodes.size() <= POSITION_MASK);
+
+		setIndex(node, bucket, static_cast<ui32>(nodes.size()));
+		nodes.push_back(node);
+
+		if(key < lastKey)
+			belowLast++;
+	}
+
+	void remove(N * node, ui32 key)
+	{
+		if(key < lastKey)
+			belowLast--;
+
+		auto & nodes = buckets[node->pqIndex >> POSITION_BITS];
+		ui32 position = node->pqIndex & POSITION_MASK;
+
+		N * last = nodes.back();
+		nodes[position] = last;
+		last->pqIndex = node->pqIndex;
+		nodes.pop_back();
+	}
+
+	void redistribute()
+	{
+		int bucket = 1;
+		while(buckets[bucket].empty())
+			bucket++;
+
+		std::vector<N *> nodes;
+		std::swap(nodes, buckets[bucket]);
+
+		lastKey = keyOf(nodes.front()->getCost());
+		for(N * node : nodes)
+			vstd::amin(lastKey, keyOf(node->getCost()));
+
+		//every node lands in lower bucket, at least minimal one goes to bucket 0
+		for(N * node : nodes)
+			insert(node, keyOf(node->getCost()));
+
+		nodes.clear();
+		std::swap(nodes, buckets[bucket]); //keep allocated capacity
+	}
+};
+
+#ifdef VCMI_PATHFINDER_RADIX_QUEUE
+	template<typename N>
+	using PathfinderQueue = RadixNodeQueue<N>;
+#else
+	template<typename N>
+	using PathfinderQueue = IndexedNodeHeap<N, VCMI_PATHFINDER_HEAP_ARITY>;
+#endif
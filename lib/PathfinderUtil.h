@@ -10,7 +10,10 @@
 #pragma once
 
 #include "mapping/CMapDefines.h"
+#include "mapping/CMap.h"
+#include "mapObjects/CGHeroInstance.h"
 #include "CGameState.h"
+#include "CPlayerState.h"
 
 namespace PathfinderUtil
 {
@@ -73,4 +76,173 @@ namespace PathfinderUtil
 
 		return CGPathNode::ACCESSIBLE;
 	}
+
+	/// Calls resetTile(pos, layer, accessibility) for every tile and layer hero may move on
+	template<typename ResetTile>
+	void evaluateTiles(const PathfinderOptions & options, const CGameState * gs, const CGHeroInstance * hero, ResetTile resetTile)
+	{
+		int3 pos;
+		const int3 sizes = gs->getMapSize();
+		const auto & fow = static_cast<const CGameInfoCallback *>(gs)->getPlayerTeam(hero->tempOwner)->fogOfWarMap;
+		const PlayerColor player = hero->tempOwner;
+
+		//make 200% sure that these are loop invariants (also a bit shorter code), let compiler do the rest(loop unswitching)
+		const bool useFlying = options.useFlying;
+		const bool useWaterWalking = options.useWaterWalking;
+
+		for(pos.x=0; pos.x < sizes.x; ++pos.x)
+		{
+			for(pos.y=0; pos.y < sizes.y; ++pos.y)
+			{
+				for(pos.z=0; pos.z < sizes.z; ++pos.z)
+				{
+					const TerrainTile * tile = &gs->map->getTile(pos);
+					switch(tile->terType)
+					{
+					case ETerrainType::ROCK:
+						break;
+
+					case ETerrainType::WATER:
+						resetTile(pos, ELayer::SAIL, evaluateAccessibility<ELayer::SAIL>(pos, tile, fow, player, gs));
+						if(useFlying)
+							resetTile(pos, ELayer::AIR, evaluateAccessibility<ELayer::AIR>(pos, tile, fow, player, gs));
+						if(useWaterWalking)
+							resetTile(pos, ELayer::WATER, evaluateAccessibility<ELayer::WATER>(pos, tile, fow, player, gs));
+						break;
+
+					default:
+						resetTile(pos, ELayer::LAND, evaluateAccessibility<ELayer::LAND>(pos, tile, fow, player, gs));
+						if(useFlying)
+							resetTile(pos, ELayer::AIR, evaluateAccessibility<ELayer::AIR>(pos, tile, fow, player, gs));
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	/// Incremental search: turns tree of previous search into tree rooted in new initial node.
+	/// Nodes are stored per layer in tile order as in CPathsInfo, theNodeBefore must link every node to its parent.
+	///
+	/// Nodes reached through root keep their paths (cost is shifted so root costs 0) unless path crosses tile
+	/// from dirtyTiles (accessibility changed since previous search), other nodes are reset.
+	/// Returns kept nodes bordering on reset ones or standing on visitable tiles (teleports),
+	/// search continues from them and repairs the rest of tree.
+	template<typename Node>
+	std::vector<CGPathNode *> rerootTree(
+		std::array<std::vector<Node>, ELayer::NUM_LAYERS> & nodes,
+		const int3 & sizes,
+		Node * root,
+		const std::vector<bool> & dirtyTiles,
+		const CGameState * gs)
+	{
+		enum ENodeState : ui8
+		{
+			UNKNOWN = 0, KEEP, DROP
+		};
+
+		std::array<std::vector<ui8>, ELayer::NUM_LAYERS> states;
+		for(int layer = 0; layer < ELayer::NUM_LAYERS; layer++)
+			states[layer].resize(nodes[layer].size(), UNKNOWN);
+
+		auto stateOf = [&](const CGPathNode * node) -> ui8 &
+		{
+			return states[node->layer][static_cast<const Node *>(node) - nodes[node->layer].data()];
+		};
+		auto tileIndex = [&](const int3 & pos) -> size_t
+		{
+			return (pos.z * sizes.y + pos.y) * sizes.x + pos.x;
+		};
+
+		const float rootCost = root->getCost();
+		std::vector<CGPathNode *> branch;
+
+		stateOf(root) = KEEP;
+
+		for(auto & layerNodes : nodes)
+		{
+			for(Node & node : layerNodes)
+			{
+				if(node.layer == ELayer::WRONG)
+					continue;
+
+				CGPathNode * current = &node;
+				while(current && stateOf(current) == UNKNOWN)
+				{
+					branch.push_back(current);
+					current = current->theNodeBefore;
+				}
+
+				//branch not leading to root is part of old root subtree
+				ui8 state = current ? stateOf(current) : static_cast<ui8>(DROP);
+				for(auto it = branch.rbegin(); it != branch.rend(); it++)
+				{
+					if(!(*it)->reachable() || dirtyTiles[tileIndex((*it)->coord)])
+						state = DROP;
+
+					stateOf(*it) = state;
+				}
+				branch.clear();
+			}
+		}
+
+		//tiles where search may find something new: reset nodes which had path and all changed tiles
+		std::vector<bool> openTiles(dirtyTiles);
+
+		for(auto & layerNodes : nodes)
+		{
+			for(Node & node : layerNodes)
+			{
+				if(node.layer == ELayer::WRONG)
+					continue;
+
+				if(stateOf(&node) == KEEP)
+				{
+					node.locked = false;
+					node.setCost(node.getCost() - rootCost);
+				}
+				else
+				{
+					if(node.reachable())
+						openTiles[tileIndex(node.coord)] = true;
+
+					node.update(node.coord, node.layer, node.accessible);
+				}
+			}
+		}
+
+		root->theNodeBefore = nullptr;
+		root->action = CGPathNode::UNKNOWN;
+
+		std::vector<CGPathNode *> frontier;
+		frontier.push_back(root);
+
+		for(auto & layerNodes : nodes)
+		{
+			for(Node & node : layerNodes)
+			{
+				if(&node == root || node.layer == ELayer::WRONG || stateOf(&node) != KEEP)
+					continue;
+
+				const int3 & pos = node.coord;
+				bool open = gs->map->getTile(pos).visitable;
+
+				for(int dx = -1; dx <= 1 && !open; dx++)
+				{
+					for(int dy = -1; dy <= 1 && !open; dy++)
+					{
+						const int3 neighbour(pos.x + dx, pos.y + dy, pos.z);
+
+						if(neighbour.x >= 0 && neighbour.x < sizes.x && neighbour.y >= 0 && neighbour.y < sizes.y)
+							open = openTiles[tileIndex(neighbour)];
+					}
+				}
+
+				if(open)
+					frontier.push_back(&node);
+			}
+		}
+
+		return frontier;
+	}
 }
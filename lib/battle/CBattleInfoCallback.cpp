@@ -166,10 +166,10 @@ bool CBattleInfoCallback::battleHasWallPenalty(const IBonusBearer * shooter, Bat
 	if(!battleGetSiegeLevel())
 		return false;
 
-	const std::string cachingStrNoWallPenalty = "type_NO_WALL_PENALTY";
+	static const auto cachingKeyNoWallPenalty = BonusCacheKey::type(Bonus::NO_WALL_PENALTY);
 	static const auto selectorNoWallPenalty = Selector::type()(Bonus::NO_WALL_PENALTY);
 
-	if(shooter->hasBonus(selectorNoWallPenalty, cachingStrNoWallPenalty))
+	if(shooter->hasBonus(selectorNoWallPenalty, cachingKeyNoWallPenalty))
 		return false;
 
 	const int wallInStackLine = lineToWallHex(shooterPosition.getY());
@@ -736,10 +736,10 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo & info)
 		return unmodifiableTowerDamage;
 	}
 
-	const std::string cachingStrSiedgeWeapon = "type_SIEGE_WEAPON";
+	static const auto cachingKeySiedgeWeapon = BonusCacheKey::type(Bonus::SIEGE_WEAPON);
 	static const auto selectorSiedgeWeapon = Selector::type()(Bonus::SIEGE_WEAPON);
 
-	if(attackerBonuses->hasBonus(selectorSiedgeWeapon, cachingStrSiedgeWeapon) && info.attacker->creatureIndex() != CreatureID::ARROW_TOWERS) //any siege weapon, but only ballista can attack (second condition - not arrow turret)
+	if(attackerBonuses->hasBonus(selectorSiedgeWeapon, cachingKeySiedgeWeapon) && info.attacker->creatureIndex() != CreatureID::ARROW_TOWERS) //any siege weapon, but only ballista can attack (second condition - not arrow turret)
 	{ //minDmg and maxDmg are multiplied by hero attack + 1
 		auto retrieveHeroPrimSkill = [&](int skill) -> int
 		{
@@ -760,11 +760,11 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo & info)
 	double multDefenceReduction = 1.0 - battleBonusValue(attackerBonuses, Selector::type()(Bonus::ENEMY_DEFENCE_REDUCTION)) / 100.0;
 	attackDefenceDifference -= info.defender->getDefense(info.shooting) * multDefenceReduction;
 
-	const std::string cachingStrSlayer = "type_SLAYER";
+	static const auto cachingKeySlayer = BonusCacheKey::type(Bonus::SLAYER);
 	static const auto selectorSlayer = Selector::type()(Bonus::SLAYER);
 
 	//slayer handling //TODO: apply only ONLY_MELEE_FIGHT / DISTANCE_FIGHT?
-	auto slayerEffects = attackerBonuses->getBonuses(selectorSlayer, cachingStrSlayer);
+	auto slayerEffects = attackerBonuses->getBonuses(selectorSlayer, cachingKeySlayer);
 
 	if(std::shared_ptr<const Bonus> slayerEffect = slayerEffects->getFirst(Selector::all))
 	{
@@ -808,56 +808,56 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo & info)
 		additiveBonus += inc;
 	}
 
-	const std::string cachingStrJousting = "type_JOUSTING";
+	static const auto cachingKeyJousting = BonusCacheKey::type(Bonus::JOUSTING);
 	static const auto selectorJousting = Selector::type()(Bonus::JOUSTING);
 
-	const std::string cachingStrChargeImmunity = "type_CHARGE_IMMUNITY";
+	static const auto cachingKeyChargeImmunity = BonusCacheKey::type(Bonus::CHARGE_IMMUNITY);
 	static const auto selectorChargeImmunity = Selector::type()(Bonus::CHARGE_IMMUNITY);
 
 	//applying jousting bonus
-	if(info.chargedFields > 0 && attackerBonuses->hasBonus(selectorJousting, cachingStrJousting) && !defenderBonuses->hasBonus(selectorChargeImmunity, cachingStrChargeImmunity))
+	if(info.chargedFields > 0 && attackerBonuses->hasBonus(selectorJousting, cachingKeyJousting) && !defenderBonuses->hasBonus(selectorChargeImmunity, cachingKeyChargeImmunity))
 		additiveBonus += info.chargedFields * 0.05;
 
 	//handling secondary abilities and artifacts giving premies to them
-	const std::string cachingStrArchery = "type_SECONDARY_SKILL_PREMYs_ARCHERY";
+	static const auto cachingKeyArchery = BonusCacheKey::typeSubtype(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::ARCHERY);
 	static const auto selectorArchery = Selector::typeSubtype(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::ARCHERY);
 
-	const std::string cachingStrOffence = "type_SECONDARY_SKILL_PREMYs_OFFENCE";
+	static const auto cachingKeyOffence = BonusCacheKey::typeSubtype(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::OFFENCE);
 	static const auto selectorOffence = Selector::typeSubtype(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::OFFENCE);
 
-	const std::string cachingStrArmorer = "type_SECONDARY_SKILL_PREMYs_ARMORER";
+	static const auto cachingKeyArmorer = BonusCacheKey::typeSubtype(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::ARMORER);
 	static const auto selectorArmorer = Selector::typeSubtype(Bonus::SECONDARY_SKILL_PREMY, SecondarySkill::ARMORER);
 
 	if(info.shooting)
-		additiveBonus += attackerBonuses->valOfBonuses(selectorArchery, cachingStrArchery) / 100.0;
+		additiveBonus += attackerBonuses->valOfBonuses(selectorArchery, cachingKeyArchery) / 100.0;
 	else
-		additiveBonus += attackerBonuses->valOfBonuses(selectorOffence, cachingStrOffence) / 100.0;
+		additiveBonus += attackerBonuses->valOfBonuses(selectorOffence, cachingKeyOffence) / 100.0;
 
-	multBonus *= (std::max(0, 100 - defenderBonuses->valOfBonuses(selectorArmorer, cachingStrArmorer))) / 100.0;
+	multBonus *= (std::max(0, 100 - defenderBonuses->valOfBonuses(selectorArmorer, cachingKeyArmorer))) / 100.0;
 
 	//handling hate effect
 	//assume that unit have only few HATE features and cache them all
-	const std::string cachingStrHate = "type_HATE";
+	static const auto cachingKeyHate = BonusCacheKey::type(Bonus::HATE);
 	static const auto selectorHate = Selector::type()(Bonus::HATE);
 
-	auto allHateEffects = attackerBonuses->getBonuses(selectorHate, cachingStrHate);
+	auto allHateEffects = attackerBonuses->getBonuses(selectorHate, cachingKeyHate);
 
 	additiveBonus += allHateEffects->valOfBonuses(Selector::subtype()(info.defender->creatureIndex())) / 100.0;
 
-	const std::string cachingStrMeleeReduction = "type_GENERAL_DAMAGE_REDUCTIONs_0";
+	static const auto cachingKeyMeleeReduction = BonusCacheKey::typeSubtype(Bonus::GENERAL_DAMAGE_REDUCTION, 0);
 	static const auto selectorMeleeReduction = Selector::typeSubtype(Bonus::GENERAL_DAMAGE_REDUCTION, 0);
 
-	const std::string cachingStrRangedReduction = "type_GENERAL_DAMAGE_REDUCTIONs_1";
+	static const auto cachingKeyRangedReduction = BonusCacheKey::typeSubtype(Bonus::GENERAL_DAMAGE_REDUCTION, 1);
 	static const auto selectorRangedReduction = Selector::typeSubtype(Bonus::GENERAL_DAMAGE_REDUCTION, 1);
 
 	//handling spell effects
 	if(!info.shooting) //eg. shield
 	{
-		multBonus *= (100 - defenderBonuses->valOfBonuses(selectorMeleeReduction, cachingStrMeleeReduction)) / 100.0;
+		multBonus *= (100 - defenderBonuses->valOfBonuses(selectorMeleeReduction, cachingKeyMeleeReduction)) / 100.0;
 	}
 	else //eg. air shield
 	{
-		multBonus *= (100 - defenderBonuses->valOfBonuses(selectorRangedReduction, cachingStrRangedReduction)) / 100.0;
+		multBonus *= (100 - defenderBonuses->valOfBonuses(selectorRangedReduction, cachingKeyRangedReduction)) / 100.0;
 	}
 
 	if(info.shooting)
@@ -865,7 +865,7 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo & info)
 		//todo: set actual percentage in spell bonus configuration instead of just level; requires non trivial backward compatibility handling
 
 		//get list first, total value of 0 also counts
-		TConstBonusListPtr forgetfulList = attackerBonuses->getBonuses(Selector::type()(Bonus::FORGETFULL),"type_FORGETFULL");
+		TConstBonusListPtr forgetfulList = attackerBonuses->getBonuses(Selector::type()(Bonus::FORGETFULL), BonusCacheKey::type(Bonus::FORGETFULL));
 
 		if(!forgetfulList->empty())
 		{
@@ -879,14 +879,14 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo & info)
 		}
 	}
 
-	const std::string cachingStrForcedMinDamage = "type_ALWAYS_MINIMUM_DAMAGE";
+	static const auto cachingKeyForcedMinDamage = BonusCacheKey::type(Bonus::ALWAYS_MINIMUM_DAMAGE);
 	static const auto selectorForcedMinDamage = Selector::type()(Bonus::ALWAYS_MINIMUM_DAMAGE);
 
-	const std::string cachingStrForcedMaxDamage = "type_ALWAYS_MAXIMUM_DAMAGE";
+	static const auto cachingKeyForcedMaxDamage = BonusCacheKey::type(Bonus::ALWAYS_MAXIMUM_DAMAGE);
 	static const auto selectorForcedMaxDamage = Selector::type()(Bonus::ALWAYS_MAXIMUM_DAMAGE);
 
-	TConstBonusListPtr curseEffects = attackerBonuses->getBonuses(selectorForcedMinDamage, cachingStrForcedMinDamage);
-	TConstBonusListPtr blessEffects = attackerBonuses->getBonuses(selectorForcedMaxDamage, cachingStrForcedMaxDamage);
+	TConstBonusListPtr curseEffects = attackerBonuses->getBonuses(selectorForcedMinDamage, cachingKeyForcedMinDamage);
+	TConstBonusListPtr blessEffects = attackerBonuses->getBonuses(selectorForcedMaxDamage, cachingKeyForcedMaxDamage);
 
 	int curseBlessAdditiveModifier = blessEffects->totalValue() - curseEffects->totalValue();
 	double curseMultiplicativePenalty = curseEffects->size() ? (*std::max_element(curseEffects->begin(), curseEffects->end(), &Bonus::compareByAdditionalInfo<std::shared_ptr<Bonus>>))->additionalInfo[0] : 0;
@@ -896,7 +896,7 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo & info)
 		multBonus *= 1.0 - curseMultiplicativePenalty/100;
 	}
 
-	const std::string cachingStrAdvAirShield = "isAdvancedAirShield";
+	static const auto cachingKeyAdvAirShield = BonusCacheKey::named("isAdvancedAirShield");
 	auto isAdvancedAirShield = [](const Bonus* bonus)
 	{
 		return bonus->source == Bonus::SPELL_EFFECT
@@ -913,7 +913,7 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo & info)
 		const bool distPenalty = battleHasDistancePenalty(attackerBonuses, attackerPos, defenderPos);
 		const bool obstaclePenalty = battleHasWallPenalty(attackerBonuses, attackerPos, defenderPos);
 
-		if(distPenalty || defenderBonuses->hasBonus(isAdvancedAirShield, cachingStrAdvAirShield))
+		if(distPenalty || defenderBonuses->hasBonus(isAdvancedAirShield, cachingKeyAdvAirShield))
 			multBonus *= 0.5;
 
 		if(obstaclePenalty)
@@ -921,20 +921,20 @@ TDmgRange CBattleInfoCallback::calculateDmgRange(const BattleAttackInfo & info)
 	}
 	else
 	{
-		const std::string cachingStrNoMeleePenalty = "type_NO_MELEE_PENALTY";
+		static const auto cachingKeyNoMeleePenalty = BonusCacheKey::type(Bonus::NO_MELEE_PENALTY);
 		static const auto selectorNoMeleePenalty = Selector::type()(Bonus::NO_MELEE_PENALTY);
 
-		if(info.attacker->isShooter() && !attackerBonuses->hasBonus(selectorNoMeleePenalty, cachingStrNoMeleePenalty))
+		if(info.attacker->isShooter() && !attackerBonuses->hasBonus(selectorNoMeleePenalty, cachingKeyNoMeleePenalty))
 			multBonus *= 0.5;
 	}
 
 	// psychic elementals versus mind immune units 50%
 	if(info.attacker->creatureIndex() == CreatureID::PSYCHIC_ELEMENTAL)
 	{
-		const std::string cachingStrMindImmunity = "type_MIND_IMMUNITY";
+		static const auto cachingKeyMindImmunity = BonusCacheKey::type(Bonus::MIND_IMMUNITY);
 		static const auto selectorMindImmunity = Selector::type()(Bonus::MIND_IMMUNITY);
 
-		if(defenderBonuses->hasBonus(selectorMindImmunity, cachingStrMindImmunity))
+		if(defenderBonuses->hasBonus(selectorMindImmunity, cachingKeyMindImmunity))
 			multBonus *= 0.5;
 	}
 
@@ -1616,10 +1616,10 @@ bool CBattleInfoCallback::battleHasDistancePenalty(const IBonusBearer * shooter,
 {
 	RETURN_IF_NOT_BATTLE(false);
 
-	const std::string cachingStrNoDistancePenalty = "type_NO_DISTANCE_PENALTY";
+	static const auto cachingKeyNoDistancePenalty = BonusCacheKey::type(Bonus::NO_DISTANCE_PENALTY);
 	static const auto selectorNoDistancePenalty = Selector::type()(Bonus::NO_DISTANCE_PENALTY);
 
-	if(shooter->hasBonus(selectorNoDistancePenalty, cachingStrNoDistancePenalty))
+	if(shooter->hasBonus(selectorNoDistancePenalty, cachingKeyNoDistancePenalty))
 		return false;
 
 	if(auto target = battleGetUnitByPos(destHex, true))
@@ -1784,10 +1784,9 @@ SpellID CBattleInfoCallback::getRandomBeneficialSpell(CRandomGenerator & rand, c
 
 	for(const SpellID spellID : allPossibleSpells)
 	{
-		std::stringstream cachingStr;
-		cachingStr << "source_" << Bonus::SPELL_EFFECT << "id_" << spellID.num;
+		const auto cachingKey = BonusCacheKey::source(Bonus::SPELL_EFFECT, spellID);
 
-		if(subject->hasBonus(Selector::source(Bonus::SPELL_EFFECT, spellID), Selector::all, cachingStr.str())
+		if(subject->hasBonus(Selector::source(Bonus::SPELL_EFFECT, spellID), Selector::all, cachingKey)
 		 //TODO: this ability has special limitations
 		|| !(spellID.toSpell()->canBeCast(this, spells::Mode::CREATURE_ACTIVE, subject)))
 			continue;
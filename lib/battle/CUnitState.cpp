@@ -894,9 +894,14 @@ CUnitStateDetached::CUnitStateDetached(const IUnitInfo * unit_, const IBonusBear
 
 }
 
-TConstBonusListPtr CUnitStateDetached::getAllBonuses(const CSelector & selector, const CSelector & limit, const CBonusSystemNode * root, const std::string & cachingStr) const
+TConstBonusListPtr CUnitStateDetached::getAllBonuses(const CSelector & selector, const CSelector & limit, const CBonusSystemNode * root, const BonusCacheKey & cachingKey) const
 {
-	return bonus->getAllBonuses(selector, limit, root, cachingStr);
+	return bonus->getAllBonuses(selector, limit, root, cachingKey);
+}
+
+bool CUnitStateDetached::getIndexedTotals(BonusList::Totals & out, const CSelector & selector, const CSelector & limit) const
+{
+	return bonus->getIndexedTotals(out, selector, limit);
 }
 
 int64_t CUnitStateDetached::getTreeVersion() const
@@ -269,7 +269,8 @@ public:
 	explicit CUnitStateDetached(const IUnitInfo * unit_, const IBonusBearer * bonus_);
 
 	TConstBonusListPtr getAllBonuses(const CSelector & selector, const CSelector & limit,
-		const CBonusSystemNode * root = nullptr, const std::string & cachingStr = "") const override;
+		const CBonusSystemNode * root = nullptr, const BonusCacheKey & cachingKey = BonusCacheKey()) const override;
+	bool getIndexedTotals(BonusList::Totals & out, const CSelector & selector, const CSelector & limit) const override;
 
 	int64_t getTreeVersion() const override;
 
@@ -42,6 +42,11 @@ boost::optional<boost::filesystem::path> CMappedFileLoader::getResourceName(cons
 	return CResourceHandler::get()->getResourceName(fileList.at(resourceName));
 }
 
+boost::optional<ui32> CMappedFileLoader::getResourceFingerprint(const ResourceID & resourceName) const
+{
+	return CResourceHandler::get()->getResourceFingerprint(fileList.at(resourceName));
+}
+
 std::unordered_set<ResourceID> CMappedFileLoader::getFilteredFiles(std::function<bool(const ResourceID &)> filter) const
 {
 	std::unordered_set<ResourceID> foundID;
@@ -55,6 +60,7 @@ std::unordered_set<ResourceID> CMappedFileLoader::getFilteredFiles(std::function
 }
 
 CFilesystemList::CFilesystemList()
+	: generation(1)
 {
 	//loaders = new std::vector<std::unique_ptr<ISimpleResourceLoader> >;
 }
@@ -64,14 +70,55 @@ CFilesystemList::~CFilesystemList()
 	//delete loaders;
 }
 
+ui64 CFilesystemList::getGeneration() const
+{
+	ui64 ret = generation;
+	for (auto & list : nestedLists)
+		ret += list->getGeneration();
+	return ret;
+}
+
+std::shared_ptr<const CFilesystemList::TIndex> CFilesystemList::getIndex() const
+{
+	const ui64 currentGeneration = getGeneration();
+
+	auto current = std::atomic_load(&index);
+	if (current && current->generation == currentGeneration)
+		return current;
+
+	boost::unique_lock<boost::mutex> lock(indexMutex);
+
+	current = std::atomic_load(&index);
+	if (current && current->generation == currentGeneration)
+		return current;
+
+	auto updated = std::make_shared<TIndex>();
+	updated->generation = currentGeneration;
+	for (auto & loader : loaders)
+		for (auto & entry : loader->getFilteredFiles([](const ResourceID &){ return true; }))
+			updated->entries[entry].push_back(loader.get());
+
+	current = updated;
+	std::atomic_store(&index, current);
+	return current;
+}
+
+std::shared_ptr<const CFilesystemList::TLoaders> CFilesystemList::findLoaders(const ResourceID & resourceName) const
+{
+	auto current = getIndex();
+
+	auto iter = current->entries.find(resourceName);
+	if (iter == current->entries.end())
+		return nullptr;
+	//shares ownership of whole index, so entry stays valid even if index gets rebuilt meanwhile
+	return std::shared_ptr<const TLoaders>(current, &iter->second);
+}
+
 std::unique_ptr<CInputStream> CFilesystemList::load(const ResourceID & resourceName) const
 {
 	// load resource from last loader that have it (last overridden version)
-	for (auto & loader : boost::adaptors::reverse(loaders))
-	{
-		if (loader->existsResource(resourceName))
-			return loader->load(resourceName);
-	}
+	if (auto found = findLoaders(resourceName))
+		return found->back()->load(resourceName);
 
 	throw std::runtime_error("Resource with name " + resourceName.getName() + " and type "
 		+ EResTypeHelper::getEResTypeAsString(resourceName.getType()) + " wasn't found.");
@@ -79,10 +126,7 @@ std::unique_ptr<CInputStream> CFilesystemList::load(const ResourceID & resourceN
 
 bool CFilesystemList::existsResource(const ResourceID & resourceName) const
 {
-	for (auto & loader : loaders)
-		if (loader->existsResource(resourceName))
-			return true;
-	return false;
+	return findLoaders(resourceName) != nullptr;
 }
 
 std::string CFilesystemList::getMountPoint() const
@@ -92,11 +136,18 @@ std::string CFilesystemList::getMountPoint() const
 
 boost::optional<boost::filesystem::path> CFilesystemList::getResourceName(const ResourceID & resourceName) const
 {
-	if (existsResource(resourceName))
-		return getResourcesWithName(resourceName).back()->getResourceName(resourceName);
+	if (auto found = findLoaders(resourceName))
+		return found->back()->getResourceName(resourceName);
 	return boost::optional<boost::filesystem::path>();
 }
 
+boost::optional<ui32> CFilesystemList::getResourceFingerprint(const ResourceID & resourceName) const
+{
+	if (auto found = findLoaders(resourceName))
+		return found->back()->getResourceFingerprint(resourceName);
+	return boost::optional<ui32>();
+}
+
 std::set<boost::filesystem::path> CFilesystemList::getResourceNames(const ResourceID & resourceName) const
 {
 	std::set<boost::filesystem::path> paths;
@@ -115,15 +166,16 @@ void CFilesystemList::updateFilteredFiles(std::function<bool(const std::string &
 {
 	for (auto & loader : loaders)
 		loader->updateFilteredFiles(filter);
+	generation++;
 }
 
 std::unordered_set<ResourceID> CFilesystemList::getFilteredFiles(std::function<bool(const ResourceID &)> filter) const
 {
 	std::unordered_set<ResourceID> ret;
 
-	for (auto & loader : loaders)
-		for (auto & entry : loader->getFilteredFiles(filter))
-			ret.insert(entry);
+	for (auto & entry : getIndex()->entries)
+		if (filter(entry.first))
+			ret.insert(entry.first);
 
 	return ret;
 }
@@ -136,6 +188,8 @@ bool CFilesystemList::createResource(std::string filename, bool update)
 		if (writeableLoaders.count(loader.get()) != 0                       // writeable,
 			&& loader->createResource(filename, update))          // successfully created
 		{
+			generation++;
+
 			// Check if resource was created successfully. Possible reasons for this to fail
 			// a) loader failed to create resource (e.g. read-only FS)
 			// b) in update mode, call with filename that does not exists
@@ -153,8 +207,9 @@ std::vector<const ISimpleResourceLoader *> CFilesystemList::getResourcesWithName
 {
 	std::vector<const ISimpleResourceLoader *> ret;
 
-	for (auto & loader : loaders)
-		boost::range::copy(loader->getResourcesWithName(resourceName), std::back_inserter(ret));
+	if (auto found = findLoaders(resourceName))
+		for (auto & loader : *found)
+			boost::range::copy(loader->getResourcesWithName(resourceName), std::back_inserter(ret));
 
 	return ret;
 }
@@ -164,4 +219,7 @@ void CFilesystemList::addLoader(ISimpleResourceLoader * loader, bool writeable)
 	loaders.push_back(std::unique_ptr<ISimpleResourceLoader>(loader));
 	if (writeable)
 		writeableLoaders.insert(loader);
+	if (auto list = dynamic_cast<const CFilesystemList *>(loader))
+		nestedLists.push_back(list);
+	generation++;
 }
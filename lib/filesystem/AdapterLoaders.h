@@ -40,6 +40,7 @@ public:
 	bool existsResource(const ResourceID & resourceName) const override;
 	std::string getMountPoint() const override;
 	boost::optional<boost::filesystem::path> getResourceName(const ResourceID & resourceName) const override;
+	boost::optional<ui32> getResourceFingerprint(const ResourceID & resourceName) const override;
 	void updateFilteredFiles(std::function<bool(const std::string &)> filter) const override {}
 	std::unordered_set<ResourceID> getFilteredFiles(std::function<bool(const ResourceID &)> filter) const override;
 
@@ -53,10 +54,38 @@ private:
 
 class DLL_LINKAGE CFilesystemList : public ISimpleResourceLoader
 {
+	typedef std::vector<const ISimpleResourceLoader *> TLoaders;
+
 	std::vector<std::unique_ptr<ISimpleResourceLoader> > loaders;
 
 	std::set<ISimpleResourceLoader *> writeableLoaders;
 
+	/// Nested lists, their changes also invalidate index of this list
+	std::vector<const CFilesystemList *> nestedLists;
+
+	/** Loaders from list that contain resource, in the same order as in loaders list (last one overrides others)
+	 * Never modified once built, lookups keep their own reference so a rebuild does not invalidate them
+	*/
+	struct TIndex
+	{
+		ui64 generation;
+		std::unordered_map<ResourceID, TLoaders> entries;
+	};
+	mutable std::shared_ptr<const TIndex> index;
+	mutable boost::mutex indexMutex;
+
+	/// Incremented on every change of this list
+	mutable std::atomic<ui64> generation;
+
+	/// @return sum of generations of this list and all nested lists, changes whenever any of them changes
+	ui64 getGeneration() const;
+
+	/// @return up-to-date index, rebuilt if this list or any nested list has changed
+	std::shared_ptr<const TIndex> getIndex() const;
+
+	/// @return loaders that contain resource or nullptr if there are none
+	std::shared_ptr<const TLoaders> findLoaders(const ResourceID & resourceName) const;
+
 	//FIXME: this is only compile fix, should be removed in the end
 	CFilesystemList(CFilesystemList &) = delete;
 	CFilesystemList &operator=(CFilesystemList &) = delete;
@@ -71,6 +100,7 @@ public:
 	std::string getMountPoint() const override;
 	boost::optional<boost::filesystem::path> getResourceName(const ResourceID & resourceName) const override;
 	std::set<boost::filesystem::path> getResourceNames(const ResourceID & resourceName) const override;
+	boost::optional<ui32> getResourceFingerprint(const ResourceID & resourceName) const override;
 	void updateFilteredFiles(std::function<bool(const std::string &)> filter) const override;
 	std::unordered_set<ResourceID> getFilteredFiles(std::function<bool(const ResourceID &)> filter) const override;
 	bool createResource(std::string filename, bool update = false) override;
@@ -12,8 +12,13 @@
 
 #include "CFileInputStream.h"
 #include "CCompressedStream.h"
+#include "CMemoryStream.h"
 
 #include "CBinaryReader.h"
+#include "FileInfo.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 
 ArchiveEntry::ArchiveEntry()
 	: offset(0), fullSize(0), compressedSize(0)
@@ -45,9 +50,62 @@ CArchiveLoader::CArchiveLoader(std::string _mountPoint, boost::filesystem::path
 	else
 		throw std::runtime_error("LOD archive format unknown. Cannot deal with " + archive.string());
 
+	mapArchive();
+
 	logGlobal->trace("%sArchive \"%s\" loaded (%d files found).", ext, archive.filename(), entries.size());
 }
 
+void CArchiveLoader::mapArchive()
+{
+	try
+	{
+		// mapped region stays valid after file mapping is closed
+		boost::interprocess::file_mapping file(archive.string().c_str(), boost::interprocess::read_only);
+		mapping = std::make_shared<boost::interprocess::mapped_region>(file, boost::interprocess::read_only);
+	}
+	catch(const boost::interprocess::interprocess_exception & e)
+	{
+		logGlobal->warn("Failed to map archive %s into memory, it will be read from file. Error: %s", archive.string(), e.what());
+		mapping.reset();
+	}
+}
+
+bool CArchiveLoader::isMapped(const ArchiveEntry & entry) const
+{
+	const si64 dataSize = entry.compressedSize != 0 ? entry.compressedSize : entry.fullSize;
+
+	return mapping
+		&& entry.offset >= 0
+		&& dataSize >= 0
+		&& static_cast<ui64>(entry.offset) + dataSize <= mapping->get_size();
+}
+
+std::shared_ptr<const ui8> CArchiveLoader::getDecompressedEntry(const ResourceID & resourceName, const ArchiveEntry & entry) const
+{
+	{
+		boost::unique_lock<boost::mutex> lock(decompressedEntriesMutex);
+		if(auto data = decompressedEntries[resourceName].lock())
+			return data;
+	}
+
+	// decompression is done without lock, in rare case of concurrent load of the same entry first result is kept
+	const ui8 * compressedData = static_cast<const ui8 *>(mapping->get_address()) + entry.offset;
+	CCompressedStream stream(make_unique<CMemoryStream>(compressedData, entry.compressedSize), false, entry.fullSize);
+
+	auto buffer = std::make_shared<std::vector<ui8>>(entry.fullSize);
+	if(stream.read(buffer->data(), entry.fullSize) != entry.fullSize)
+		throw std::runtime_error("Failed to decompress " + resourceName.getName() + " from " + archive.string());
+
+	std::shared_ptr<const ui8> data(buffer, buffer->data());
+
+	boost::unique_lock<boost::mutex> lock(decompressedEntriesMutex);
+	auto & cached = decompressedEntries[resourceName];
+	if(auto existing = cached.lock())
+		return existing;
+	cached = data;
+	return data;
+}
+
 void CArchiveLoader::initLODArchive(const std::string &mountPoint, CFileInputStream & fileStream)
 {
 	// Read count of total files
@@ -146,6 +204,15 @@ std::unique_ptr<CInputStream> CArchiveLoader::load(const ResourceID & resourceNa
 
 	const ArchiveEntry & entry = entries.at(resourceName);
 
+	if (isMapped(entry))
+	{
+		if (entry.compressedSize != 0)
+			return make_unique<CMemoryStream>(getDecompressedEntry(resourceName, entry), entry.fullSize);
+
+		const ui8 * entryData = static_cast<const ui8 *>(mapping->get_address()) + entry.offset;
+		return make_unique<CMemoryStream>(std::shared_ptr<const ui8>(mapping, entryData), entry.fullSize);
+	}
+
 	if (entry.compressedSize != 0) //compressed data
 	{
 		auto fileStream = make_unique<CFileInputStream>(archive, entry.offset, entry.compressedSize);
@@ -168,6 +235,14 @@ std::string CArchiveLoader::getMountPoint() const
 	return mountPoint;
 }
 
+boost::optional<ui32> CArchiveLoader::getResourceFingerprint(const ResourceID & resourceName) const
+{
+	const ArchiveEntry & entry = entries.at(resourceName);
+	const std::string location = boost::str(boost::format("%d:%d:%d") % entry.offset % entry.fullSize % entry.compressedSize);
+
+	return FileInfo::GetFileFingerprint(archive, location);
+}
+
 std::unordered_set<ResourceID> CArchiveLoader::getFilteredFiles(std::function<bool(const ResourceID &)> filter) const
 {
 	std::unordered_set<ResourceID> foundID;
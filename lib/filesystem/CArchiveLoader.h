@@ -14,6 +14,14 @@
 
 class CFileInputStream;
 
+namespace boost
+{
+	namespace interprocess
+	{
+		class mapped_region;
+	}
+}
+
 /**
  * A struct which holds information about the archive entry e.g. where it is located in space of the archive container.
  */
@@ -39,6 +47,8 @@ struct ArchiveEntry
 
 /**
  * A class which can scan and load files of a LOD archive.
+ * Archive is mapped into memory if possible: uncompressed entries are served directly from mapping,
+ * compressed entries are decompressed once and shared while anyone holds them.
  */
 class DLL_LINKAGE CArchiveLoader : public ISimpleResourceLoader
 {
@@ -60,6 +70,7 @@ public:
 	std::unique_ptr<CInputStream> load(const ResourceID & resourceName) const override;
 	bool existsResource(const ResourceID & resourceName) const override;
 	std::string getMountPoint() const override;
+	boost::optional<ui32> getResourceFingerprint(const ResourceID & resourceName) const override;
 	void updateFilteredFiles(std::function<bool(const std::string &)> filter) const override {}
 	std::unordered_set<ResourceID> getFilteredFiles(std::function<bool(const ResourceID &)> filter) const override;
 
@@ -85,6 +96,15 @@ private:
 	 */
 	void initSNDArchive(const std::string &mountPoint, CFileInputStream & fileStream);
 
+	/** Maps archive into memory, archive is read through file streams if this fails */
+	void mapArchive();
+
+	/** @return true if data of entry can be accessed through mapping */
+	bool isMapped(const ArchiveEntry & entry) const;
+
+	/** @return decompressed data of entry, shared with other users of the same entry */
+	std::shared_ptr<const ui8> getDecompressedEntry(const ResourceID & resourceName, const ArchiveEntry & entry) const;
+
 	/** The file path to the archive which is scanned and indexed. */
 	boost::filesystem::path archive;
 
@@ -92,4 +112,11 @@ private:
 
 	/** Holds all entries of the archive file. An entry can be accessed via the entry name. **/
 	std::unordered_map<ResourceID, ArchiveEntry> entries;
+
+	/** Read-only mapping of whole archive or null if archive is not mapped */
+	std::shared_ptr<boost::interprocess::mapped_region> mapping;
+
+	/** Decompressed entries that are still in use somewhere */
+	mutable std::unordered_map<ResourceID, std::weak_ptr<const ui8>> decompressedEntries;
+	mutable boost::mutex decompressedEntriesMutex;
 };
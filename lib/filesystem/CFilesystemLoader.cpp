@@ -12,6 +12,7 @@
 
 #include "CFileInputStream.h"
 #include "FileStream.h"
+#include "FileInfo.h"
 
 namespace bfs = boost::filesystem;
 
@@ -48,6 +49,13 @@ boost::optional<boost::filesystem::path> CFilesystemLoader::getResourceName(cons
 	return baseDirectory / fileList.at(resourceName);
 }
 
+boost::optional<ui32> CFilesystemLoader::getResourceFingerprint(const ResourceID & resourceName) const
+{
+	assert(existsResource(resourceName));
+
+	return FileInfo::GetFileFingerprint(baseDirectory / fileList.at(resourceName));
+}
+
 void CFilesystemLoader::updateFilteredFiles(std::function<bool(const std::string &)> filter) const
 {
 	if (filter(mountPoint))
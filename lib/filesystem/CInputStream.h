@@ -48,6 +48,17 @@ public:
 		return std::make_pair(std::move(data), getSize());
 	}
 
+	/**
+	 * @brief reads whole stream at once, streams that already hold data in memory return it without copying
+	 *
+	 * @return pair, first = read-only data that stays valid while pointer is held, second = size of data
+	 */
+	virtual std::pair<std::shared_ptr<const ui8>, si64> readShared()
+	{
+		auto data = readAll();
+		return std::make_pair(std::shared_ptr<const ui8>(data.first.release(), std::default_delete<ui8[]>()), data.second);
+	}
+
 	/**
 	 * @brief calculateCRC32 calculates CRC32 checksum for the whole file
 	 * @return calculated checksum
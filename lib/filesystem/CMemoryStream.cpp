@@ -16,6 +16,12 @@ CMemoryStream::CMemoryStream(const ui8 * data, si64 size) :
 
 }
 
+CMemoryStream::CMemoryStream(std::shared_ptr<const ui8> data, si64 size) :
+	sharedData(std::move(data)), data(sharedData.get()), size(size), position(0)
+{
+
+}
+
 si64 CMemoryStream::read(ui8 * data, si64 size)
 {
 	si64 toRead = std::min(this->size - tell(), size);
@@ -47,3 +53,10 @@ si64 CMemoryStream::getSize()
 {
 	return size;
 }
+
+std::pair<std::shared_ptr<const ui8>, si64> CMemoryStream::readShared()
+{
+	if(sharedData)
+		return std::make_pair(sharedData, size);
+	return CInputStream::readShared();
+}
@@ -26,6 +26,14 @@ public:
 	 */
 	CMemoryStream(const ui8 * data, si64 size);
 
+	/**
+	 * C-tor. The data buffer is shared with this stream and kept alive as long as stream exists.
+	 *
+	 * @param data a pointer to the data array.
+	 * @param size The size in bytes of the array.
+	 */
+	CMemoryStream(std::shared_ptr<const ui8> data, si64 size);
+
 	/**
 	 * Reads n bytes from the stream into the data buffer.
 	 *
@@ -65,7 +73,15 @@ public:
 	 */
 	si64 getSize() override;
 
+	/**
+	 * Returns shared data buffer without copying, if stream was created with one.
+	 */
+	std::pair<std::shared_ptr<const ui8>, si64> readShared() override;
+
 private:
+	/** Owner of the data array, null if stream does not own it. */
+	std::shared_ptr<const ui8> sharedData;
+
 	/** A pointer to the data array. */
 	const ui8 * data;
 
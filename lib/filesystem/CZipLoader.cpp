@@ -10,6 +10,7 @@
 #include "StdInc.h"
 #include "CZipLoader.h"
 #include "FileStream.h"
+#include "FileInfo.h"
 
 #include "../ScopeGuard.h"
 
@@ -107,6 +108,14 @@ std::string CZipLoader::getMountPoint() const
 	return mountPoint;
 }
 
+boost::optional<ui32> CZipLoader::getResourceFingerprint(const ResourceID & resourceName) const
+{
+	const unz64_file_pos & position = files.at(resourceName);
+	const std::string location = boost::str(boost::format("%d:%d") % position.pos_in_zip_directory % position.num_of_file);
+
+	return FileInfo::GetFileFingerprint(archiveName, location);
+}
+
 std::unordered_set<ResourceID> CZipLoader::getFilteredFiles(std::function<bool(const ResourceID &)> filter) const
 {
 	std::unordered_set<ResourceID> foundID;
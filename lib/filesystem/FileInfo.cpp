@@ -11,6 +11,8 @@
 
 #include "FileInfo.h"
 
+#include <boost/crc.hpp>
+
 namespace FileInfo
 {
 
@@ -62,4 +64,26 @@ boost::string_ref GetPathStem(boost::string_ref path)
 	return path.substr(0, dotPos);
 }
 
+boost::optional<ui32> GetFileFingerprint(const boost::filesystem::path & path, boost::string_ref extra)
+{
+	boost::system::error_code ec;
+
+	const auto size = boost::filesystem::file_size(path, ec);
+	if (ec)
+		return boost::optional<ui32>();
+
+	const auto modified = boost::filesystem::last_write_time(path, ec);
+	if (ec)
+		return boost::optional<ui32>();
+
+	const std::string name = path.string();
+
+	boost::crc_32_type checksum;
+	checksum.process_bytes(name.data(), name.size());
+	checksum.process_bytes(&size, sizeof(size));
+	checksum.process_bytes(&modified, sizeof(modified));
+	checksum.process_bytes(extra.data(), extra.size());
+	return checksum.checksum();
+}
+
 }
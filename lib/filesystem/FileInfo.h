@@ -49,4 +49,12 @@ boost::string_ref DLL_LINKAGE GetParentPath(boost::string_ref path);
  */
 boost::string_ref DLL_LINKAGE GetPathStem(boost::string_ref path);
 
+/**
+ * Gets checksum of file path, size and modification time. It changes whenever file is replaced or modified.
+ *
+ * @param extra data mixed into checksum, e.g. position of entry inside of archive
+ * @return the checksum or empty optional if file is not accessible
+ */
+boost::optional<ui32> DLL_LINKAGE GetFileFingerprint(const boost::filesystem::path & path, boost::string_ref extra = boost::string_ref());
+
 }
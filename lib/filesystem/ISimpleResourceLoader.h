@@ -52,6 +52,17 @@ public:
 		return boost::optional<boost::filesystem::path>();
 	}
 
+	/**
+	 * Gets fingerprint of resource that changes whenever its data changes, without reading the data,
+	 * e.g. checksum of archive location, size and modification time. Used to validate caches of data derived from resource.
+	 *
+	 * @return fingerprint or empty optional if loader can't provide it
+	 */
+	virtual boost::optional<ui32> getResourceFingerprint(const ResourceID & resourceName) const
+	{
+		return boost::optional<ui32>();
+	}
+
 	/**
 	 * Gets all full names of matching resources, e.g. names of files in filesystem.
 	 *
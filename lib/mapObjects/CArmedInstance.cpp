@@ -61,7 +61,7 @@ void CArmedInstance::updateMoraleBonusFromArmy()
 	std::set<TFaction> factions;
 	bool hasUndead = false;
 
-	const std::string undeadCacheKey = "type_UNDEAD";
+	static const auto undeadCacheKey = BonusCacheKey::type(Bonus::UNDEAD);
 	static const CSelector undeadSelector = Selector::type()(Bonus::UNDEAD);
 
 	for(auto slot : Slots())
@@ -102,7 +102,7 @@ void CArmedInstance::updateMoraleBonusFromArmy()
 		b->description = b->description.substr(0, b->description.size()-2);//trim value
 	}
 	boost::algorithm::trim(b->description);
-	CBonusSystemNode::treeHasChanged();
+	nodeHasChanged();
 
 	//-1 modifier for any Undead unit in army
 	const ui8 UNDEAD_MODIFIER_ID = -2;
@@ -0,0 +1,137 @@
+/*
+ * CMapHeaderCache.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include "CMapHeaderCache.h"
+
+#include "../serializer/BinaryDeserializer.h"
+#include "../serializer/BinarySerializer.h"
+#include "../CModHandler.h"
+#include "../VCMI_Lib.h"
+
+static const std::string MAP_HEADER_CACHE_MAGIC = "VCMIMHC";
+
+CMapHeaderCache::CMapHeaderCache(const boost::filesystem::path & cacheFile)
+	: cacheFile(cacheFile), modsChecksum(getActiveModsChecksum()), changed(false), hits(0), misses(0)
+{
+	if(!boost::filesystem::exists(cacheFile))
+		return;
+
+	try
+	{
+		//header format follows serialization version, so cache from any other version is useless
+		CLoadFile file(cacheFile, SERIALIZATION_VERSION);
+		file.checkMagicBytes(MAP_HEADER_CACHE_MAGIC);
+
+		ui32 checksum;
+		file >> checksum;
+		if(checksum != modsChecksum)
+		{
+			logGlobal->debug("Map header cache %s is outdated, active mods have changed", cacheFile.string());
+			changed = true;
+			return;
+		}
+		file >> entries;
+		logGlobal->debug("Loaded %d map headers from cache %s", entries.size(), cacheFile.string());
+	}
+	catch(const std::exception & e)
+	{
+		logGlobal->warn("Failed to load map header cache %s: %s", cacheFile.string(), e.what());
+		entries.clear();
+		changed = true;
+	}
+}
+
+std::unique_ptr<CMapHeader> CMapHeaderCache::get(const boost::filesystem::path & mapFile)
+{
+	si64 modified;
+	ui64 size;
+	if(getFileInfo(mapFile, modified, size))
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		auto found = entries.find(mapFile.string());
+		if(found != entries.end() && found->second.modified == modified && found->second.size == size)
+		{
+			found->second.used = true;
+			hits++;
+			return make_unique<CMapHeader>(found->second.header);
+		}
+	}
+	misses++;
+	return nullptr;
+}
+
+void CMapHeaderCache::put(const boost::filesystem::path & mapFile, const CMapHeader & header)
+{
+	Entry entry;
+	if(!getFileInfo(mapFile, entry.modified, entry.size))
+		return;
+	entry.header = header;
+	entry.used = true;
+
+	boost::unique_lock<boost::mutex> lock(mx);
+	entries[mapFile.string()] = entry;
+	changed = true;
+}
+
+void CMapHeaderCache::save()
+{
+	boost::unique_lock<boost::mutex> lock(mx);
+
+	for(auto it = entries.begin(); it != entries.end();)
+	{
+		if(it->second.used)
+		{
+			it++;
+		}
+		else
+		{
+			it = entries.erase(it);
+			changed = true;
+		}
+	}
+
+	if(!changed)
+		return;
+
+	try
+	{
+		CSaveFile file(cacheFile);
+		file.putMagicBytes(MAP_HEADER_CACHE_MAGIC);
+		file << modsChecksum << entries;
+		changed = false;
+	}
+	catch(const std::exception & e)
+	{
+		logGlobal->warn("Failed to save map header cache %s: %s", cacheFile.string(), e.what());
+	}
+}
+
+ui32 CMapHeaderCache::getActiveModsChecksum()
+{
+	//mods may change content of header, e.g. list of allowed heroes
+	boost::crc_32_type crc;
+	for(const auto & mod : VLC->modh->getActiveMods())
+	{
+		ui32 checksum = VLC->modh->getModData(mod).checksum;
+		crc.process_bytes(mod.data(), mod.size());
+		crc.process_bytes(&checksum, sizeof(checksum));
+	}
+	return crc.checksum();
+}
+
+bool CMapHeaderCache::getFileInfo(const boost::filesystem::path & file, si64 & modified, ui64 & size)
+{
+	boost::system::error_code ec;
+	modified = boost::filesystem::last_write_time(file, ec);
+	if(ec)
+		return false;
+	size = boost::filesystem::file_size(file, ec);
+	return !ec;
+}
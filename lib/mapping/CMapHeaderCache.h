@@ -0,0 +1,62 @@
+/*
+ * CMapHeaderCache.h, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#pragma once
+
+#include "CMap.h"
+
+/// Persistent cache of map headers listed in lobby, so unchanged map files are not parsed again.
+/// Entries are keyed by full path of map file and become stale once its size or modification time changes.
+/// Whole cache is discarded if set of active mods has changed.
+class DLL_LINKAGE CMapHeaderCache : public boost::noncopyable
+{
+public:
+	/// Loads cache from file, missing or outdated file results in empty cache
+	CMapHeaderCache(const boost::filesystem::path & cacheFile);
+
+	/// Returns copy of cached header or nullptr if map is not in cache or has changed since. Thread-safe
+	std::unique_ptr<CMapHeader> get(const boost::filesystem::path & mapFile);
+	/// Stores header of map file. Thread-safe
+	void put(const boost::filesystem::path & mapFile, const CMapHeader & header);
+
+	/// Writes cache to disk if it has changed, entries not requested since cache was loaded are dropped
+	void save();
+
+	size_t getHits() const { return hits; }
+	size_t getMisses() const { return misses; }
+
+	struct Entry
+	{
+		si64 modified;
+		ui64 size;
+		CMapHeader header;
+		bool used; //not serialized, set if entry was requested in this session
+
+		Entry(): modified(0), size(0), used(false) {}
+
+		template <typename Handler> void serialize(Handler & h, const int version)
+		{
+			h & modified;
+			h & size;
+			h & header;
+		}
+	};
+
+private:
+	boost::filesystem::path cacheFile;
+	ui32 modsChecksum;
+	std::map<std::string, Entry> entries;
+	bool changed;
+	std::atomic<size_t> hits;
+	std::atomic<size_t> misses;
+	boost::mutex mx;
+
+	static ui32 getActiveModsChecksum();
+	static bool getFileInfo(const boost::filesystem::path & file, si64 & modified, ui64 & size);
+};
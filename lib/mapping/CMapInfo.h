@@ -21,6 +21,7 @@
 #include "CCampaignHandler.h"
 
 struct StartInfo;
+class CMapHeaderCache;
 
 /**
  * A class which stores the count of human players and all players, the filename,
@@ -44,7 +45,9 @@ public:
 
 	CMapInfo &operator=(CMapInfo &&other);
 
-	void mapInit(const std::string & fname);
+	/// Thread-safe, header is taken from cache if given and map file has not changed
+	void mapInit(const std::string & fname, CMapHeaderCache * cache = nullptr);
+	/// Thread-safe
 	void saveInit(ResourceID file);
 	void campaignInit();
 	void countPlayers();
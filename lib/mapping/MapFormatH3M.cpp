@@ -15,7 +15,9 @@
 #include "CMap.h"
 
 #include "../CStopWatch.h"
+#include "../ScopeGuard.h"
 #include "../filesystem/Filesystem.h"
+#include "../filesystem/CMemoryStream.h"
 #include "../spells/CSpellHandler.h"
 #include "../CSkillHandler.h"
 #include "../CCreatureHandler.h"
@@ -27,8 +29,6 @@
 #include "../NetPacksBase.h"
 
 
-const bool CMapLoaderH3M::IS_PROFILING_ENABLED = false;
-
 CMapLoaderH3M::CMapLoaderH3M(CInputStream * stream) : map(nullptr), reader(stream),inputStream(stream)
 {
 }
@@ -58,22 +58,22 @@ std::unique_ptr<CMapHeader> CMapLoaderH3M::loadMapHeader()
 
 void CMapLoaderH3M::init()
 {
-	//FIXME: get rid of double input process
-	si64 temp_size = inputStream->getSize();
-	inputStream->seek(0);
+	CStopWatch sw;
 
-	auto  temp_buffer = new ui8[temp_size];
-	inputStream->read(temp_buffer,temp_size);
+	// Whole map is decompressed once, checksum and all further reading use the same buffer
+	inputStream->seek(0);
+	auto mapData = inputStream->readShared();
 
-	// Compute checksum
 	boost::crc_32_type  result;
-	result.process_bytes(temp_buffer, temp_size);
+	result.process_bytes(mapData.first.get(), mapData.second);
 	map->checksum = result.checksum();
 
-	delete [] temp_buffer;
-	inputStream->seek(0);
-
-	CStopWatch sw;
+	CMemoryStream mapStream(mapData.first, mapData.second);
+	reader.setStream(&mapStream);
+	auto restoreStream = vstd::makeScopeGuard([&]()
+	{
+		reader.setStream(inputStream);
+	});
 
 	struct MapLoadingTime
 	{
@@ -87,6 +87,7 @@ void CMapLoaderH3M::init()
 		}
 	};
 	std::vector<MapLoadingTime> times;
+	times.push_back(MapLoadingTime("decompression", sw.getDiff()));
 
 	readHeader();
 	times.push_back(MapLoadingTime("header", sw.getDiff()));
@@ -120,18 +121,24 @@ void CMapLoaderH3M::init()
 	readEvents();
 	times.push_back(MapLoadingTime("events", sw.getDiff()));
 
-	times.push_back(MapLoadingTime("blocked/visitable tiles", sw.getDiff()));
+	map->calculateGuardingGreaturePositions();
+	times.push_back(MapLoadingTime("guarded tiles", sw.getDiff()));
+
+	afterRead();
+	times.push_back(MapLoadingTime("post-processing", sw.getDiff()));
 
-	// Print profiling times
-	if(IS_PROFILING_ENABLED)
+	// Print timing report
+	if(logGlobal->isDebugEnabled())
 	{
+		si64 total = 0;
+		std::string report;
 		for(MapLoadingTime & mlt : times)
 		{
-			logGlobal->debug("\tReading %s took %d ms", mlt.name, mlt.time);
+			total += mlt.time;
+			report += boost::str(boost::format("\n\t%s: %d ms") % mlt.name % mlt.time);
 		}
+		logGlobal->debug("Map %s loaded in %d ms:%s", mapHeader->name, total, report);
 	}
-	map->calculateGuardingGreaturePositions();
-	afterRead();
 }
 
 void CMapLoaderH3M::readHeader()
@@ -913,28 +920,33 @@ void CMapLoaderH3M::readTerrain()
 {
 	map->initTerrain();
 
-	// Read terrain
-	for(int a = 0; a < 2; ++a)
-	{
-		if(a == 1 && !map->twoLevel)
-		{
-			break;
-		}
+	// Read terrain as single block, 7 bytes per tile
+	static const int TILE_SIZE = 7;
+	const int levels = map->twoLevel ? 2 : 1;
+	const si64 terrainSize = static_cast<si64>(levels) * map->width * map->height * TILE_SIZE;
 
+	std::vector<ui8> terrain(terrainSize);
+	if(reader.read(terrain.data(), terrainSize) != terrainSize)
+		throw std::runtime_error("Unexpected end of terrain data");
+
+	const ui8 * tileData = terrain.data();
+	for(int a = 0; a < levels; ++a)
+	{
 		for(int c = 0; c < map->width; c++)
 		{
 			for(int z = 0; z < map->height; z++)
 			{
 				auto & tile = map->getTile(int3(z, c, a));
-				tile.terType = ETerrainType(reader.readUInt8());
-				tile.terView = reader.readUInt8();
-				tile.riverType = static_cast<ERiverType::ERiverType>(reader.readUInt8());
-				tile.riverDir = reader.readUInt8();
-				tile.roadType = static_cast<ERoadType::ERoadType>(reader.readUInt8());
-				tile.roadDir = reader.readUInt8();
-				tile.extTileFlags = reader.readUInt8();
+				tile.terType = ETerrainType(tileData[0]);
+				tile.terView = tileData[1];
+				tile.riverType = static_cast<ERiverType::ERiverType>(tileData[2]);
+				tile.riverDir = tileData[3];
+				tile.roadType = static_cast<ERoadType::ERoadType>(tileData[4]);
+				tile.roadDir = tileData[5];
+				tile.extTileFlags = tileData[6];
 				tile.blocked = ((tile.terType == ETerrainType::ROCK || tile.terType == ETerrainType::BORDER ) ? true : false); //underground tiles are always blocked
 				tile.visitable = 0;
+				tileData += TILE_SIZE;
 			}
 		}
 	}
@@ -949,15 +961,15 @@ void CMapLoaderH3M::readDefInfo()
 	// Read custom defs
 	for(int idd = 0; idd < defAmount; ++idd)
 	{
-		ObjectTemplate tmpl;
-		tmpl.readMap(reader);
-		templates.push_back(tmpl);
+		templates.push_back(ObjectTemplate());
+		templates.back().readMap(reader);
 	}
 }
 
 void CMapLoaderH3M::readObjects()
 {
 	int howManyObjs = reader.readUInt32();
+	map->objects.reserve(map->objects.size() + howManyObjs);
 
 	for(int ww = 0; ww < howManyObjs; ++ww)
 	{
@@ -1486,11 +1498,7 @@ void CMapLoaderH3M::readObjects()
 
 		{
 			//TODO: define valid typeName and subtypeName fro H3M maps
-			//boost::format fmt("%s_%d");
-			//fmt % nobj->typeName % nobj->id.getNum();
-			boost::format fmt("obj_%d");
-			fmt % nobj->id.getNum();
-			nobj->instanceName = fmt.str();
+			nobj->instanceName = "obj_" + boost::lexical_cast<std::string>(nobj->id.getNum());
 		}
 		map->addNewObject(nobj);
 	}
@@ -9,14 +9,19 @@
  */
 #include "StdInc.h"
 #include "BinaryDeserializer.h"
+#include "BinarySerializer.h"
 #include "../filesystem/FileStream.h"
 
 #include "../registerTypes/RegisterTypes.h"
 
+#include <zlib.h>
+
+static const size_t inflateBlockSize = 64 * 1024;
+
 extern template void registerTypes<BinaryDeserializer>(BinaryDeserializer & s);
 
 CLoadFile::CLoadFile(const boost::filesystem::path & fname, int minimalVersion)
-	: serializer(this)
+	: inflateState(nullptr), compressedRemaining(0), serializer(this)
 {
 	registerTypes(serializer);
 	openNextFile(fname, minimalVersion);
@@ -24,19 +29,90 @@ CLoadFile::CLoadFile(const boost::filesystem::path & fname, int minimalVersion)
 
 CLoadFile::~CLoadFile()
 {
+	endInflate();
 }
 
 int CLoadFile::read(void * data, unsigned size)
 {
+	if(inflateState)
+		return inflateData(static_cast<ui8 *>(data), size);
+
 	sfile->read((char*)data,size);
 	return size;
 }
 
+void CLoadFile::initInflate()
+{
+	inflateState = new z_stream;
+	inflateState->zalloc = Z_NULL;
+	inflateState->zfree = Z_NULL;
+	inflateState->opaque = Z_NULL;
+	inflateState->avail_in = 0;
+	inflateState->next_in = Z_NULL;
+
+	if(inflateInit(inflateState) != Z_OK)
+	{
+		vstd::clear_pointer(inflateState);
+		THROW_FORMAT("Error: failed to initialize decompression of %s!", fName);
+	}
+
+	//remaining part of file is compressed state
+	const auto statePosition = sfile->tellg();
+	sfile->seekg(0, std::ios::end);
+	compressedRemaining = sfile->tellg() - statePosition;
+	sfile->seekg(statePosition);
+
+	compressedBuffer.resize(inflateBlockSize);
+}
+
+void CLoadFile::endInflate()
+{
+	if(inflateState)
+	{
+		inflateEnd(inflateState);
+		vstd::clear_pointer(inflateState);
+	}
+	compressedBuffer.clear();
+	compressedRemaining = 0;
+}
+
+int CLoadFile::inflateData(ui8 * data, unsigned size)
+{
+	inflateState->next_out = data;
+	inflateState->avail_out = size;
+
+	while(inflateState->avail_out > 0)
+	{
+		if(inflateState->avail_in == 0)
+		{
+			const auto blockSize = std::min<si64>(compressedRemaining, compressedBuffer.size());
+			if(blockSize == 0)
+				THROW_FORMAT("Error: unexpected end of compressed data in %s!", fName);
+
+			sfile->read(reinterpret_cast<char *>(compressedBuffer.data()), blockSize);
+			compressedRemaining -= blockSize;
+			inflateState->next_in = compressedBuffer.data();
+			inflateState->avail_in = static_cast<uInt>(blockSize);
+		}
+
+		int ret = inflate(inflateState, Z_NO_FLUSH);
+		if(ret == Z_STREAM_END && inflateState->avail_out > 0)
+			THROW_FORMAT("Error: reading past the end of compressed data in %s!", fName);
+		if(ret != Z_OK && ret != Z_STREAM_END)
+			THROW_FORMAT("Error: decompression of %s failed: %s", fName % (inflateState->msg ? inflateState->msg : "unknown error"));
+	}
+	return size;
+}
+
 void CLoadFile::openNextFile(const boost::filesystem::path & fname, int minimalVersion)
 {
 	assert(!serializer.reverseEndianess);
 	assert(minimalVersion <= SERIALIZATION_VERSION);
 
+	//file may be still written by background thread
+	CSaveFile::waitForPendingWrites();
+	endInflate();
+
 	try
 	{
 		fName = fname.string();
@@ -72,6 +148,16 @@ void CLoadFile::openNextFile(const boost::filesystem::path & fname, int minimalV
 			else
 				THROW_FORMAT("Error: too new file format (%s)!", fName);
 		}
+
+		if(serializer.fileVersion >= 801)
+		{
+			ui8 compression;
+			serializer & compression;
+			if(compression == CSaveFile::ZLIB_COMPRESSION)
+				initInflate();
+			else if(compression != CSaveFile::NO_COMPRESSION)
+				THROW_FORMAT("Error: unknown compression method %d (%s)!", static_cast<int>(compression) % fName);
+		}
 	}
 	catch(...)
 	{
@@ -89,6 +175,7 @@ void CLoadFile::reportState(vstd::CLoggerBase * out)
 
 void CLoadFile::clear()
 {
+	endInflate();
 	sfile = nullptr;
 	fName.clear();
 	serializer.fileVersion = 0;
@@ -17,6 +17,7 @@
 
 class CStackInstance;
 class FileStream;
+struct z_stream_s;
 
 class DLL_LINKAGE CLoaderBase
 {
@@ -512,8 +513,16 @@ public:
 	}
 };
 
+/// Reads files written by CSaveFile, compressed state is inflated while it is being read
 class DLL_LINKAGE CLoadFile : public IBinaryReader
 {
+	z_stream_s * inflateState; //null if file is not compressed
+	std::vector<ui8> compressedBuffer;
+	si64 compressedRemaining; //bytes of compressed data not yet read from file
+
+	void initInflate();
+	void endInflate();
+	int inflateData(ui8 * data, unsigned size);
 public:
 	BinaryDeserializer serializer;
 
@@ -10,13 +10,175 @@
 #include "StdInc.h"
 #include "BinarySerializer.h"
 #include "../filesystem/FileStream.h"
+#include "../CStopWatch.h"
+#include "../CThreadHelper.h"
+#include "../ScopeGuard.h"
 
 #include "../registerTypes/RegisterTypes.h"
 
+#include <zlib.h>
+
 extern template void registerTypes<BinarySerializer>(BinarySerializer & s);
 
-CSaveFile::CSaveFile(const boost::filesystem::path &fname)
-	: serializer(this)
+static const size_t deflateBlockSize = 64 * 1024;
+
+/// Writes closed save files on background thread, one by one in order in which they were closed
+class CSaveFileWriter : public boost::noncopyable
+{
+public:
+	struct Job
+	{
+		boost::filesystem::path fName;
+		std::vector<ui8> data;
+		size_t headerSize;
+		CSaveFile::ECompression compression;
+		CSaveFile::TWriteCallback callback;
+	};
+
+	static CSaveFileWriter & get()
+	{
+		//never destroyed, background thread may still use it during static deinitialization
+		static CSaveFileWriter * instance = new CSaveFileWriter();
+		return *instance;
+	}
+
+	void push(Job && job)
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		jobs.push_back(std::move(job));
+		if(!working)
+		{
+			working = true;
+			boost::thread(&CSaveFileWriter::run, this).detach();
+		}
+	}
+
+	void wait()
+	{
+		boost::unique_lock<boost::mutex> lock(mx);
+		while(working)
+			finished.wait(lock);
+	}
+
+private:
+	boost::mutex mx;
+	boost::condition_variable finished;
+	std::deque<Job> jobs;
+	bool working = false;
+
+	void run()
+	{
+		setThreadName("CSaveFileWriter");
+
+		boost::unique_lock<boost::mutex> lock(mx);
+		while(!jobs.empty())
+		{
+			Job job = std::move(jobs.front());
+			jobs.pop_front();
+
+			lock.unlock();
+			writeJob(job);
+			job = Job(); //release snapshot before reporting that writes are done
+			lock.lock();
+		}
+		working = false;
+		finished.notify_all();
+	}
+
+	static void writeJob(Job & job)
+	{
+		//target is replaced only by complete file, so crash during writing leaves previous save intact
+		boost::filesystem::path tempName = job.fName;
+		tempName += ".tmp";
+
+		std::string error;
+		try
+		{
+			CStopWatch timer;
+			ui64 written = job.headerSize;
+			{
+				FileStream file(tempName, std::ios::out | std::ios::binary | std::ios::trunc);
+				file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+
+				file.write(reinterpret_cast<const char *>(job.data.data()), job.headerSize);
+				if(job.compression == CSaveFile::ZLIB_COMPRESSION)
+				{
+					written += writeCompressed(file, job.data, job.headerSize);
+				}
+				else
+				{
+					file.write(reinterpret_cast<const char *>(job.data.data() + job.headerSize), job.data.size() - job.headerSize);
+					written = job.data.size();
+				}
+				file.flush();
+			}
+			boost::filesystem::rename(tempName, job.fName);
+
+			logGlobal->info("Written %s: %d bytes of state stored as %d bytes in %d ms", job.fName.string(), job.data.size(), written, timer.getDiff());
+		}
+		catch(std::exception & e)
+		{
+			error = e.what();
+			logGlobal->error("Failed to write %s: %s", job.fName.string(), error);
+
+			boost::system::error_code ec;
+			boost::filesystem::remove(tempName, ec);
+		}
+
+		if(job.callback)
+			job.callback(error);
+	}
+
+	static ui64 writeCompressed(FileStream & file, const std::vector<ui8> & data, size_t begin)
+	{
+		z_stream state;
+		state.zalloc = Z_NULL;
+		state.zfree = Z_NULL;
+		state.opaque = Z_NULL;
+
+		//saving happens during gameplay, speed is more important than ratio
+		if(deflateInit(&state, Z_BEST_SPEED) != Z_OK)
+			throw std::runtime_error("Failed to initialize deflate!");
+
+		auto onExit = vstd::makeScopeGuard([&]()
+		{
+			deflateEnd(&state);
+		});
+
+		std::vector<ui8> output(deflateBlockSize);
+		ui64 written = 0;
+		size_t position = begin;
+		int flush = Z_NO_FLUSH;
+
+		do
+		{
+			const size_t blockSize = std::min(data.size() - position, deflateBlockSize);
+			state.next_in = const_cast<ui8 *>(data.data() + position);
+			state.avail_in = static_cast<uInt>(blockSize);
+			position += blockSize;
+			flush = position == data.size() ? Z_FINISH : Z_NO_FLUSH;
+
+			do
+			{
+				state.next_out = output.data();
+				state.avail_out = static_cast<uInt>(output.size());
+				if(deflate(&state, flush) == Z_STREAM_ERROR)
+					throw std::runtime_error("Failed to compress data!");
+
+				const size_t compressedSize = output.size() - state.avail_out;
+				file.write(reinterpret_cast<const char *>(output.data()), compressedSize);
+				written += compressedSize;
+			}
+			while(state.avail_out == 0);
+		}
+		while(flush != Z_FINISH);
+
+		return written;
+	}
+};
+
+CSaveFile::CSaveFile(const boost::filesystem::path &fname, ECompression compression)
+	: serializer(this), headerSize(0), compression(compression)
 {
 	registerTypes(serializer);
 	openNextFile(fname);
@@ -24,49 +186,78 @@ CSaveFile::CSaveFile(const boost::filesystem::path &fname)
 
 CSaveFile::~CSaveFile()
 {
+	try
+	{
+		close();
+	}
+	catch(std::exception & e)
+	{
+		logGlobal->error("Failed to save to %s: %s", fName.string(), e.what());
+	}
 }
 
 int CSaveFile::write(const void * data, unsigned size)
 {
-	sfile->write((char *)data,size);
+	auto bytes = static_cast<const ui8 *>(data);
+	buffer.insert(buffer.end(), bytes, bytes + size);
 	return size;
 }
 
 void CSaveFile::openNextFile(const boost::filesystem::path &fname)
 {
+	close();
+
+	//file is opened only by background writer, errors are reported through write callback
 	fName = fname;
-	try
-	{
-		sfile = make_unique<FileStream>(fname, std::ios::out | std::ios::binary);
-		sfile->exceptions(std::ifstream::failbit | std::ifstream::badbit); //we throw a lot anyway
+	write("VCMI", 4); //write magic identifier
+	serializer & SERIALIZATION_VERSION; //write format version
+	serializer & static_cast<ui8>(compression); //write compression method of state
+	headerSize = buffer.size();
+}
 
-		if(!(*sfile))
-			THROW_FORMAT("Error: cannot open to write %s!", fname);
+void CSaveFile::close()
+{
+	if(fName.empty())
+		return;
 
-		sfile->write("VCMI",4); //write magic identifier
-		serializer & SERIALIZATION_VERSION; //write format version
-	}
-	catch(...)
-	{
-		logGlobal->error("Failed to save to %s", fname.string());
-		clear();
-		throw;
-	}
+	logGlobal->info("Serialized %s: %d bytes", fName.string(), buffer.size());
+
+	CSaveFileWriter::Job job;
+	job.fName = fName;
+	job.data = std::move(buffer);
+	job.headerSize = headerSize;
+	job.compression = compression;
+	job.callback = std::move(writeCallback);
+	CSaveFileWriter::get().push(std::move(job));
+
+	clear();
+}
+
+void CSaveFile::onWritten(TWriteCallback callback)
+{
+	writeCallback = std::move(callback);
+}
+
+void CSaveFile::waitForPendingWrites()
+{
+	CSaveFileWriter::get().wait();
 }
 
 void CSaveFile::reportState(vstd::CLoggerBase * out)
 {
 	out->debug("CSaveFile");
-	if(sfile.get() && *sfile)
+	if(!fName.empty())
 	{
-		out->debug("\tOpened %s \tPosition: %d", fName, sfile->tellp());
+		out->debug("\tOpened %s \tPosition: %d", fName, buffer.size());
 	}
 }
 
 void CSaveFile::clear()
 {
 	fName.clear();
-	sfile = nullptr;
+	buffer.clear();
+	headerSize = 0;
+	writeCallback = nullptr;
 }
 
 void CSaveFile::putMagicBytes(const std::string &text)
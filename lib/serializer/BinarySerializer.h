@@ -346,15 +346,30 @@ public:
 	}
 };
 
+/// Saves state into memory buffer, file is written (and compressed) on background thread once CSaveFile is closed
+/// File is written under temporary name and renamed over target when complete, so previous save stays intact until then
+/// File layout: "VCMI" magic, format version, compression method, serialized state (zlib stream if compressed)
 class DLL_LINKAGE CSaveFile : public IBinaryWriter
 {
 public:
+	enum ECompression : ui8
+	{
+		NO_COMPRESSION = 0,
+		ZLIB_COMPRESSION = 1
+	};
+
+	/// called on background thread once file is written, error is empty on success
+	typedef std::function<void(const std::string & error)> TWriteCallback;
+
 	BinarySerializer serializer;
 
 	boost::filesystem::path fName;
-	std::unique_ptr<FileStream> sfile;
+	std::vector<ui8> buffer; //header and snapshot of state being saved
+	size_t headerSize; //part of buffer that is never compressed
+	ECompression compression;
+	TWriteCallback writeCallback;
 
-	CSaveFile(const boost::filesystem::path &fname); //throws!
+	CSaveFile(const boost::filesystem::path &fname, ECompression compression = ZLIB_COMPRESSION); //throws!
 	~CSaveFile();
 	int write(const void * data, unsigned size) override;
 
@@ -364,10 +379,19 @@ public:
 
 	void putMagicBytes(const std::string &text);
 
+	/// Sets callback to report result of writing current file
+	void onWritten(TWriteCallback callback);
+
+	/// Blocks until all closed save files are written to disk (in this process)
+	static void waitForPendingWrites();
+
 	template<class T>
 	CSaveFile & operator<<(const T &t)
 	{
 		serializer & t;
 		return * this;
 	}
+
+private:
+	void close(); //passes buffer to background writer
 };
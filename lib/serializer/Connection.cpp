@@ -13,8 +13,10 @@
 #include "../registerTypes/RegisterTypes.h"
 #include "../mapping/CMap.h"
 #include "../CGameState.h"
+#include "../ScopeGuard.h"
 
 #include <boost/asio.hpp>
+#include <boost/core/demangle.hpp>
 
 using namespace boost;
 using namespace boost::asio::ip;
@@ -29,6 +31,13 @@ using namespace boost::asio::ip;
 #define LIL_ENDIAN
 #endif
 
+static const size_t FRAME_HEADER_SIZE = 4;
+//exchanged before anything else, peers with different protocol can't parse each other's packs
+//1 - each primitive written directly to socket, 2 - packs sent as length-prefixed frames
+static const std::string HANDSHAKE_GREETING = "Aiya! Protocol 2\n";
+static const size_t MAX_RETAINED_BUFFER_SIZE = 1024 * 1024; //buffers grown by big packs (e.g. game start) are released afterwards
+static const size_t MAX_FRAME_SIZE = 256 * 1024 * 1024; //larger frame can only come from damaged or hostile peer
+
 
 void CConnection::init()
 {
@@ -46,10 +55,15 @@ void CConnection::init()
 	myEndianess = false;
 #endif
 	connected = true;
-	std::string pom;
+	std::string greeting, pom;
 	//we got connection
-	oser & std::string("Aiya!\n") & name & uuid & myEndianess; //identify ourselves
-	iser & pom & pom & contactUuid & contactEndianess;
+	oser & HANDSHAKE_GREETING & name & uuid & myEndianess; //identify ourselves
+	iser & greeting & pom & contactUuid & contactEndianess;
+	if(greeting != HANDSHAKE_GREETING)
+	{
+		logNetwork->error("Connection with %s uses incompatible network protocol!", pom);
+		throw std::runtime_error("Incompatible network protocol");
+	}
 	logNetwork->info("Established connection with %s. UUID: %s", pom, contactUuid);
 	mutexRead = std::make_shared<boost::mutex>();
 	mutexWrite = std::make_shared<boost::mutex>();
@@ -58,7 +72,7 @@ void CConnection::init()
 }
 
 CConnection::CConnection(std::string host, ui16 port, std::string Name, std::string UUID)
-	: io_service(std::make_shared<asio::io_service>()), iser(this), oser(this), name(Name), uuid(UUID), connectionID(0)
+	: io_service(std::make_shared<asio::io_service>()), frameBuffer(nullptr), readPos(0), readingFrame(false), vectorsSource(nullptr), iser(this), oser(this), name(Name), uuid(UUID), connectionID(0)
 {
 	int i;
 	boost::system::error_code error = asio::error::host_not_found;
@@ -111,12 +125,12 @@ connerror1:
 	throw std::runtime_error("Can't establish connection :(");
 }
 CConnection::CConnection(std::shared_ptr<TSocket> Socket, std::string Name, std::string UUID)
-	: iser(this), oser(this), socket(Socket), name(Name), uuid(UUID), connectionID(0)
+	: frameBuffer(nullptr), readPos(0), readingFrame(false), vectorsSource(nullptr), iser(this), oser(this), socket(Socket), name(Name), uuid(UUID), connectionID(0)
 {
 	init();
 }
 CConnection::CConnection(std::shared_ptr<TAcceptor> acceptor, std::shared_ptr<boost::asio::io_service> io_service, std::string Name, std::string UUID)
-	: io_service(io_service), iser(this), oser(this), name(Name), uuid(UUID), connectionID(0)
+	: io_service(io_service), frameBuffer(nullptr), readPos(0), readingFrame(false), vectorsSource(nullptr), iser(this), oser(this), name(Name), uuid(UUID), connectionID(0)
 {
 	boost::system::error_code error = asio::error::host_not_found;
 	socket = std::make_shared<tcp::socket>(*io_service);
@@ -131,6 +145,13 @@ CConnection::CConnection(std::shared_ptr<TAcceptor> acceptor, std::shared_ptr<bo
 }
 int CConnection::write(const void * data, unsigned size)
 {
+	if(frameBuffer)
+	{
+		auto bytes = static_cast<const ui8 *>(data);
+		frameBuffer->insert(frameBuffer->end(), bytes, bytes + size);
+		return size;
+	}
+
 	try
 	{
 		int ret;
@@ -146,6 +167,16 @@ int CConnection::write(const void * data, unsigned size)
 }
 int CConnection::read(void * data, unsigned size)
 {
+	if(readingFrame)
+	{
+		if(readBuffer.size() < readPos + size)
+			throw std::runtime_error(boost::str(boost::format("Cannot read past the end of frame (accessing index %d, while size is %d)!") % (readPos + size - 1) % readBuffer.size()));
+
+		std::memcpy(data, readBuffer.data() + readPos, size);
+		readPos += size;
+		return size;
+	}
+
 	try
 	{
 		int ret = static_cast<int>(asio::read(*socket,asio::mutable_buffers_1(asio::mutable_buffer(data,size))));
@@ -158,6 +189,62 @@ int CConnection::read(void * data, unsigned size)
 		throw;
 	}
 }
+
+void CConnection::writeFrame(const std::vector<ui8> & payload, const std::type_info & packType)
+{
+	if(payload.size() > MAX_FRAME_SIZE)
+		throw std::runtime_error(boost::str(boost::format("Pack %s is too big to be sent (%d bytes)!") % packType.name() % payload.size()));
+
+	std::array<ui8, FRAME_HEADER_SIZE> header;
+	const ui32 payloadSize = static_cast<ui32>(payload.size());
+	for(size_t i = 0; i < FRAME_HEADER_SIZE; i++)
+		header[i] = static_cast<ui8>(payloadSize >> (8 * i));
+
+	std::array<asio::const_buffer, 2> frame =
+	{{
+		asio::buffer(header),
+		asio::buffer(payload)
+	}};
+
+	try
+	{
+		asio::write(*socket, frame);
+	}
+	catch(...)
+	{
+		//connection has been lost
+		connected = false;
+		throw;
+	}
+
+	auto & counter = sentTraffic[std::type_index(packType)];
+	counter.packets++;
+	counter.bytes += FRAME_HEADER_SIZE + payloadSize;
+}
+
+void CConnection::readFrame()
+{
+	std::array<ui8, FRAME_HEADER_SIZE> header;
+	read(header.data(), FRAME_HEADER_SIZE);
+
+	ui32 payloadSize = 0;
+	for(size_t i = 0; i < FRAME_HEADER_SIZE; i++)
+		payloadSize |= static_cast<ui32>(header[i]) << (8 * i);
+
+	if(payloadSize > MAX_FRAME_SIZE)
+	{
+		//rest of stream can't be trusted either
+		connected = false;
+		throw std::runtime_error(boost::str(boost::format("Received frame of %d bytes exceeds limit of %d bytes!") % payloadSize % MAX_FRAME_SIZE));
+	}
+
+	if(readBuffer.capacity() > MAX_RETAINED_BUFFER_SIZE && payloadSize <= MAX_RETAINED_BUFFER_SIZE)
+		std::vector<ui8>().swap(readBuffer);
+
+	readBuffer.resize(payloadSize);
+	read(readBuffer.data(), payloadSize);
+	readPos = 0;
+}
 CConnection::~CConnection()
 {
 	if(handler)
@@ -203,24 +290,123 @@ CPack * CConnection::retrievePack()
 {
 	CPack * pack = nullptr;
 	boost::unique_lock<boost::mutex> lock(*mutexRead);
-	iser & pack;
+	readFrame();
+	{
+		readingFrame = true;
+		auto onExit = vstd::makeScopeGuard([&]()
+		{
+			readingFrame = false;
+		});
+		iser & pack;
+	}
 	logNetwork->trace("Received CPack of type %s", (pack ? typeid(*pack).name() : "nullptr"));
+	if(readPos != readBuffer.size())
+		logNetwork->error("Pack did not consume whole frame, %d bytes left! You should check whether client and server ABI matches.", readBuffer.size() - readPos);
+
 	if(pack == nullptr)
 	{
 		logNetwork->error("Received a nullptr CPack! You should check whether client and server ABI matches.");
 	}
 	else
 	{
+		auto & counter = receivedTraffic[std::type_index(typeid(*pack))];
+		counter.packets++;
+		counter.bytes += FRAME_HEADER_SIZE + readBuffer.size();
 		pack->c = this->shared_from_this();
 	}
 	return pack;
 }
 
+void CConnection::serializePack(const CPack * pack, std::vector<ui8> & payload)
+{
+	payload.clear();
+	frameBuffer = &payload;
+	auto onExit = vstd::makeScopeGuard([&]()
+	{
+		frameBuffer = nullptr;
+	});
+	oser & pack;
+}
+
 void CConnection::sendPack(const CPack * pack)
 {
 	boost::unique_lock<boost::mutex> lock(*mutexWrite);
 	logNetwork->trace("Sending a pack of type %s", typeid(*pack).name());
-	oser & pack;
+
+	if(writeBuffer.capacity() > MAX_RETAINED_BUFFER_SIZE)
+		std::vector<ui8>().swap(writeBuffer);
+	serializePack(pack, writeBuffer);
+	writeFrame(writeBuffer, typeid(*pack));
+}
+
+void CConnection::sendPack(const CPack * pack, EncodedPack & encoded)
+{
+	boost::unique_lock<boost::mutex> lock(*mutexWrite);
+
+	if(!canShareEncoding())
+	{
+		logNetwork->trace("Sending a pack of type %s", typeid(*pack).name());
+		serializePack(pack, writeBuffer);
+		writeFrame(writeBuffer, typeid(*pack));
+		return;
+	}
+
+	const EncodingState state = getEncodingState();
+	if(!encoded.state || !(*encoded.state == state))
+	{
+		logNetwork->trace("Encoding a pack of type %s", typeid(*pack).name());
+		encoded.state.reset();
+		serializePack(pack, encoded.payload);
+		encoded.state = state;
+	}
+	logNetwork->trace("Sending an encoded pack of type %s", typeid(*pack).name());
+	writeFrame(encoded.payload, typeid(*pack));
+}
+
+bool CConnection::canShareEncoding() const
+{
+	//with smart pointers enabled each connection refers to pointers it has already sent
+	return !oser.smartPointerSerialization;
+}
+
+CConnection::EncodingState CConnection::getEncodingState() const
+{
+	EncodingState ret;
+	ret.sendStackInstanceByIds = sendStackInstanceByIds;
+	ret.smartVectorMembersSerialization = smartVectorMembersSerialization;
+	ret.vectorsSource = vectorsSource;
+	return ret;
+}
+
+bool CConnection::EncodingState::operator==(const EncodingState & other) const
+{
+	return sendStackInstanceByIds == other.sendStackInstanceByIds
+		&& smartVectorMembersSerialization == other.smartVectorMembersSerialization
+		&& vectorsSource == other.vectorsSource;
+}
+
+CConnection::TrafficStatistics CConnection::namedTraffic(const TTrafficCounters & counters)
+{
+	TrafficStatistics ret;
+	for(auto & entry : counters)
+	{
+		auto & counter = ret[boost::core::demangle(entry.first.name())];
+		counter.packets += entry.second.packets;
+		counter.bytes += entry.second.bytes;
+	}
+	return ret;
+}
+
+CConnection::TrafficStatistics CConnection::getSentTraffic() const
+{
+	boost::unique_lock<boost::mutex> lock(*mutexWrite);
+	return namedTraffic(sentTraffic);
+}
+
+CConnection::TrafficStatistics CConnection::getReceivedTraffic() const
+{
+	boost::unique_lock<boost::mutex> lock(*mutexRead);
+	return namedTraffic(receivedTraffic);
 }
 
 void CConnection::disableStackSendingByID()
@@ -249,6 +435,7 @@ void CConnection::enterLobbyConnectionMode()
 	oser.savedPointers.clear();
 	disableSmartVectorMemberSerialization();
 	disableSmartPointerSerialization();
+	vectorsSource = nullptr;
 }
 
 void CConnection::enterGameplayConnectionMode(CGameState * gs)
@@ -256,6 +443,7 @@ void CConnection::enterGameplayConnectionMode(CGameState * gs)
 	enableStackSendingByID();
 	disableSmartPointerSerialization();
 	addStdVecItems(gs);
+	vectorsSource = gs;
 }
 
 void CConnection::disableSmartVectorMemberSerialization()
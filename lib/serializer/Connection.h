@@ -12,6 +12,8 @@
 #include "BinaryDeserializer.h"
 #include "BinarySerializer.h"
 
+#include <typeindex>
+
 struct CPack;
 
 #if BOOST_VERSION >= 107000  // Boost version >= 1.70
@@ -53,16 +55,65 @@ typedef boost::asio::basic_socket_acceptor<boost::asio::ip::tcp, boost::asio::so
 
 /// Main class for network communication
 /// Allows establishing connection and bidirectional read-write
+/// After handshake every pack is sent as single frame: 4-byte little-endian payload size followed by serialized pack
 class DLL_LINKAGE CConnection
 	: public IBinaryReader, public IBinaryWriter, public std::enable_shared_from_this<CConnection>
 {
+public:
+	/// Traffic of single pack type, bytes include frame header
+	struct TrafficCounter
+	{
+		ui64 packets = 0;
+		ui64 bytes = 0;
+	};
+	typedef std::map<std::string, TrafficCounter> TrafficStatistics; //pack type name -> traffic
+
+	/// Connection settings that affect bytes produced by serializer
+	struct EncodingState
+	{
+		bool sendStackInstanceByIds;
+		bool smartVectorMembersSerialization;
+		const CGameState * vectorsSource; //game state which vectors are registered for smart vector members
+
+		bool operator==(const EncodingState & other) const;
+	};
+
+	/// Pack serialized by one connection, reused by other connections with the same encoding state
+	/// Used to broadcast pack without serializing it for each client
+	struct EncodedPack
+	{
+		std::vector<ui8> payload;
+		boost::optional<EncodingState> state; //empty if nothing was encoded yet
+	};
+
+private:
+	typedef std::map<std::type_index, TrafficCounter> TTrafficCounters;
+
 	void init();
 	void reportState(vstd::CLoggerBase * out) override;
 
 	int write(const void * data, unsigned size) override;
 	int read(void * data, unsigned size) override;
 
+	bool canShareEncoding() const; //true if serialized packs do not depend on previously sent data
+	EncodingState getEncodingState() const;
+	void serializePack(const CPack * pack, std::vector<ui8> & payload); //requires mutexWrite
+	void writeFrame(const std::vector<ui8> & payload, const std::type_info & packType); //requires mutexWrite
+	void readFrame(); //fills readBuffer with payload of next frame, requires mutexRead
+	static TrafficStatistics namedTraffic(const TTrafficCounters & counters);
+
 	std::shared_ptr<boost::asio::io_service> io_service; //can be empty if connection made from socket
+
+	//frames are assembled and parsed in memory, socket is accessed directly only during handshake
+	std::vector<ui8> writeBuffer;
+	std::vector<ui8> readBuffer;
+	std::vector<ui8> * frameBuffer; //target of write() while pack is serialized
+	size_t readPos; //index of the next byte to be read from readBuffer
+	bool readingFrame;
+	const CGameState * vectorsSource;
+
+	TTrafficCounters sentTraffic; //guarded by mutexWrite
+	TTrafficCounters receivedTraffic; //guarded by mutexRead
 public:
 	BinaryDeserializer iser;
 	BinarySerializer oser;
@@ -91,6 +142,10 @@ public:
 
 	CPack * retrievePack();
 	void sendPack(const CPack * pack);
+	void sendPack(const CPack * pack, EncodedPack & encoded); //reuses or fills encoded payload when possible
+
+	TrafficStatistics getSentTraffic() const;
+	TrafficStatistics getReceivedTraffic() const;
 
 	void disableStackSendingByID();
 	void enableStackSendingByID();
@@ -103,18 +158,4 @@ public:
 	void enterGameplayConnectionMode(CGameState * gs);
 
 	std::string toString() const;
-
-	template<class T>
-	CConnection & operator>>(T &t)
-	{
-		iser & t;
-		return * this;
-	}
-
-	template<class T>
-	CConnection & operator<<(const T &t)
-	{
-		oser & t;
-		return * this;
-	}
 };
@@ -263,9 +263,8 @@ bool UnitEffect::isReceptive(const Mechanics * m, const battle::Unit * unit) con
 		//ignore all immunities, except specific absolute immunity(VCMI addition)
 
 		//SPELL_IMMUNITY absolute case
-		std::stringstream cachingStr;
-		cachingStr << "type_" << Bonus::SPELL_IMMUNITY << "subtype_" << m->getSpellIndex() << "addInfo_1";
-		return !unit->hasBonus(Selector::typeSubtypeInfo(Bonus::SPELL_IMMUNITY, m->getSpellIndex(), 1), cachingStr.str());
+		const auto cachingKey = BonusCacheKey::typeSubtypeInfo(Bonus::SPELL_IMMUNITY, m->getSpellIndex(), 1);
+		return !unit->hasBonus(Selector::typeSubtypeInfo(Bonus::SPELL_IMMUNITY, m->getSpellIndex(), 1), cachingKey);
 	}
 	else
 	{
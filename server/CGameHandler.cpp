@@ -2715,8 +2715,7 @@ void CGameHandler::sendMessageTo(std::shared_ptr<CConnection> c, const std::stri
 {
 	SystemMessage sm;
 	sm.text = message;
-	boost::unique_lock<boost::mutex> lock(*c->mutexWrite);
-	*(c.get()) << &sm;
+	c->sendPack(&sm);
 }
 
 void CGameHandler::giveHeroBonus(GiveBonus * bonus)
@@ -2868,12 +2867,13 @@ void CGameHandler::heroExchange(ObjectInstanceID hero1, ObjectInstanceID hero2)
 void CGameHandler::sendToAllClients(CPackForClient * pack)
 {
 	logNetwork->trace("\tSending to all clients: %s", typeid(*pack).name());
+	CConnection::EncodedPack encoded; //pack is serialized once and reused by connections in the same state
 	for (auto c : lobby->connections)
 	{
 		if(!c->isOpen())
 			continue;
 
-		c->sendPack(pack);
+		c->sendPack(pack, encoded);
 	}
 }
 
@@ -2908,7 +2908,7 @@ void CGameHandler::sendAndApply(NewStructures * pack)
 	checkVictoryLossConditionsForPlayer(getTown(pack->tid)->tempOwner);
 }
 
-void CGameHandler::save(const std::string & filename)
+void CGameHandler::save(const std::string & filename, std::shared_ptr<CConnection> requester)
 {
 	logGlobal->info("Saving to %s", filename);
 	const auto stem	= FileInfo::GetPathStem(filename);
@@ -2928,8 +2928,24 @@ void CGameHandler::save(const std::string & filename)
 			saveCommonState(save);
 			logGlobal->info("Saving server state");
 			save << *this;
+
+			//file is written in background, connection is thread-safe while handler may be gone by then
+			save.onWritten([requester](const std::string & error)
+			{
+				if(error.empty())
+				{
+					logGlobal->info("Game has been successfully saved!");
+					return;
+				}
+
+				logGlobal->error("Failed to save game: %s", error);
+				if(requester && requester->isOpen())
+				{
+					SystemMessage sm("Failed to save game: " + error);
+					requester->sendPack(&sm);
+				}
+			});
 		}
-		logGlobal->info("Game has been successfully saved!");
 	}
 	catch(std::exception &e)
 	{
@@ -248,7 +248,7 @@ public:
 	bool razeStructure(ObjectInstanceID tid, BuildingID bid);
 	bool disbandCreature( ObjectInstanceID id, SlotID pos );
 	bool arrangeStacks( ObjectInstanceID id1, ObjectInstanceID id2, ui8 what, SlotID p1, SlotID p2, si32 val, PlayerColor player);
-	void save(const std::string &fname);
+	void save(const std::string &fname, std::shared_ptr<CConnection> requester = nullptr);
 	void load(const std::string &fname);
 
 	void handleTimeEvents();
@@ -371,6 +371,7 @@ void CVCMIServer::handleReceivedPack(std::unique_ptr<CPackForLobby> pack)
 
 void CVCMIServer::announcePack(std::unique_ptr<CPackForLobby> pack)
 {
+	CConnection::EncodedPack encoded;
 	for(auto c : connections)
 	{
 		// FIXME: we need to avoid senting something to client that not yet get answer for LobbyClientConnected
@@ -378,7 +379,7 @@ void CVCMIServer::announcePack(std::unique_ptr<CPackForLobby> pack)
 		if(c->uuid == uuid && !dynamic_cast<LobbyClientConnected *>(pack.get()))
 			continue;
 
-		c->sendPack(pack.get());
+		c->sendPack(pack.get(), encoded);
 	}
 
 	applier->getApplier(typeList.getTypeID(pack.get()))->applyOnServerAfter(this, pack.get());
@@ -961,6 +962,7 @@ int main(int argc, char * argv[])
 	CAndroidVMHelper envHelper;
 	envHelper.callStaticVoidMethod(CAndroidVMHelper::NATIVE_METHODS_DEFAULT_CLASS, "killServer");
 #endif
+	CSaveFile::waitForPendingWrites();
 	logConfig.deconfigure();
 	vstd::clear_pointer(VLC);
 	return 0;
@@ -82,8 +82,7 @@ CGameState * CPackForServer::GS(CGameHandler * gh)
 
 bool SaveGame::applyGh(CGameHandler * gh)
 {
-	gh->save(fname);
-	logGlobal->info("Game has been saved as %s", fname);
+	gh->save(fname, c);
 	return true;
 }
 
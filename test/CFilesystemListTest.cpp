@@ -0,0 +1,102 @@
+/*
+ * CFilesystemListTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include "../lib/filesystem/AdapterLoaders.h"
+#include "../lib/filesystem/CFilesystemLoader.h"
+#include "../lib/JsonNode.h"
+
+struct CFilesystemListTest : testing::Test
+{
+	CFilesystemList subject;
+
+	//mapped loader does not touch disk until resource is loaded
+	static ISimpleResourceLoader * makeLoader(const std::vector<std::string> & files)
+	{
+		JsonNode config;
+		for(auto & file : files)
+			config[file].String() = "TARGET.TXT";
+		return new CMappedFileLoader("", config);
+	}
+};
+
+TEST_F(CFilesystemListTest, findsResourcesOfAllLoaders)
+{
+	subject.addLoader(makeLoader({"A.TXT"}), false);
+	subject.addLoader(makeLoader({"B.TXT"}), false);
+
+	EXPECT_TRUE(subject.existsResource(ResourceID("A.TXT")));
+	EXPECT_TRUE(subject.existsResource(ResourceID("B.TXT")));
+	EXPECT_FALSE(subject.existsResource(ResourceID("C.TXT")));
+	EXPECT_FALSE(subject.existsResource(ResourceID("A.JSON")));
+	EXPECT_TRUE(subject.getResourcesWithName(ResourceID("C.TXT")).empty());
+}
+
+TEST_F(CFilesystemListTest, laterLoadersOverrideEarlierOnes)
+{
+	auto first = makeLoader({"A.TXT", "B.TXT"});
+	auto second = makeLoader({"B.TXT"});
+	subject.addLoader(first, false);
+	subject.addLoader(second, false);
+
+	auto overridden = subject.getResourcesWithName(ResourceID("B.TXT"));
+	ASSERT_EQ(overridden.size(), 2);
+	EXPECT_EQ(overridden[0], first);
+	EXPECT_EQ(overridden[1], second);
+
+	auto single = subject.getResourcesWithName(ResourceID("A.TXT"));
+	ASSERT_EQ(single.size(), 1);
+	EXPECT_EQ(single[0], first);
+}
+
+TEST_F(CFilesystemListTest, seesChangesOfNestedLists)
+{
+	auto nested = new CFilesystemList();
+	subject.addLoader(nested, false);
+
+	EXPECT_FALSE(subject.existsResource(ResourceID("A.TXT")));
+
+	auto loader = makeLoader({"A.TXT"});
+	nested->addLoader(loader, false);
+
+	EXPECT_TRUE(subject.existsResource(ResourceID("A.TXT")));
+
+	auto found = subject.getResourcesWithName(ResourceID("A.TXT"));
+	ASSERT_EQ(found.size(), 1);
+	EXPECT_EQ(found[0], loader);
+
+	auto files = subject.getFilteredFiles([](const ResourceID &){ return true; });
+	EXPECT_EQ(files.size(), 1);
+}
+
+TEST_F(CFilesystemListTest, fingerprintChangesWithFile)
+{
+	const auto directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+	boost::filesystem::create_directories(directory);
+
+	auto writeFile = [&](const std::string & text)
+	{
+		std::ofstream file((directory / "A.TXT").string(), std::ios::binary | std::ios::trunc);
+		file << text;
+	};
+
+	writeFile("first");
+	subject.addLoader(new CFilesystemLoader("", directory), false);
+
+	auto original = subject.getResourceFingerprint(ResourceID("A.TXT"));
+	ASSERT_TRUE(original);
+	EXPECT_EQ(subject.getResourceFingerprint(ResourceID("A.TXT")), original);
+	EXPECT_FALSE(subject.getResourceFingerprint(ResourceID("B.TXT")));
+
+	writeFile("second version");
+	EXPECT_NE(subject.getResourceFingerprint(ResourceID("A.TXT")), original);
+
+	boost::filesystem::remove_all(directory);
+}
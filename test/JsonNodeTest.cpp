@@ -0,0 +1,69 @@
+/*
+ * JsonNodeTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "../lib/JsonNode.h"
+
+static JsonNode parse(const std::string & text)
+{
+	return JsonNode(text.data(), text.size());
+}
+
+TEST(JsonNodeTest, parsesNestedData)
+{
+	JsonNode node = parse("{ \"a\" : 1, \"b#override\" : { \"c\" : [1, 2.5, \"x\", true, null, {\"d\" : \"e\"}] }, \"s\" : \"str\\n\" }");
+
+	EXPECT_EQ(node["a"].Integer(), 1);
+	ASSERT_EQ(node["b"].flags.size(), 1);
+	EXPECT_EQ(node["b"].flags[0], "override");
+
+	const JsonVector & vector = node["b"]["c"].Vector();
+	ASSERT_EQ(vector.size(), 6);
+	EXPECT_EQ(vector[1].Float(), 2.5);
+	EXPECT_EQ(vector[2].String(), "x");
+	EXPECT_TRUE(vector[3].Bool());
+	EXPECT_TRUE(vector[4].isNull());
+	EXPECT_EQ(vector[5]["d"].String(), "e");
+	EXPECT_EQ(node["s"].String(), "str\n");
+}
+
+TEST(JsonNodeTest, duplicatedKeyKeepsLastValue)
+{
+	JsonNode node = parse("{ \"a\" : \"first\", \"a\" : \"second\" }");
+
+	EXPECT_EQ(node.Struct().size(), 1);
+	EXPECT_EQ(node["a"].String(), "second");
+}
+
+TEST(JsonNodeTest, moveLeavesSourceNull)
+{
+	JsonNode source = parse("{ \"a\" : [1, 2, 3] }");
+	const JsonNode copy(source);
+
+	JsonNode moved(std::move(source));
+	EXPECT_EQ(moved, copy);
+	EXPECT_TRUE(source.isNull());
+
+	JsonNode assigned;
+	assigned = std::move(moved);
+	EXPECT_EQ(assigned, copy);
+}
+
+TEST(JsonNodeTest, mergeKeepsExistingEntries)
+{
+	JsonNode dest = parse("{ \"a\" : 5, \"z\" : \"keep\" }");
+	JsonNode source = parse("{ \"a\" : 2, \"b\" : { \"c\" : [1, 2] } }");
+
+	JsonUtils::merge(dest, source);
+
+	EXPECT_EQ(dest["a"].Integer(), 2);
+	EXPECT_EQ(dest["z"].String(), "keep");
+	EXPECT_EQ(dest["b"]["c"].Vector().size(), 2);
+}
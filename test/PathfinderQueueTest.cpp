@@ -0,0 +1,154 @@
+/*
+ * PathfinderQueueTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "../lib/PathfinderQueue.h"
+
+namespace
+{
+struct TestNode
+{
+	float cost;
+	ui32 pqIndex;
+	bool inQueue;
+
+	float getCost() const
+	{
+		return cost;
+	}
+};
+}
+
+template<typename Q>
+class PathfinderQueueTest : public testing::Test
+{
+public:
+	Q subject;
+	std::vector<TestNode> nodes;
+	std::mt19937 rand;
+
+	PathfinderQueueTest()
+		: nodes(1000),
+		rand(42)
+	{
+	}
+
+	float randomCost(float from)
+	{
+		//turns and fraction of turn, like pathfinder cost
+		return from + std::uniform_int_distribution<int>(0, 20)(rand) / 8.0f;
+	}
+
+	void push(TestNode & node, float cost)
+	{
+		node.cost = cost;
+		node.inQueue = true;
+		subject.push(&node);
+	}
+
+	void setCost(TestNode & node, float cost)
+	{
+		float oldCost = node.cost;
+		node.cost = cost;
+		subject.update(&node, oldCost);
+	}
+
+	TestNode * pop()
+	{
+		TestNode * node = subject.top();
+		subject.pop();
+		node->inQueue = false;
+		return node;
+	}
+};
+
+typedef testing::Types<IndexedNodeHeap<TestNode, 2>, IndexedNodeHeap<TestNode, 4>, RadixNodeQueue<TestNode>> TQueues;
+TYPED_TEST_CASE(PathfinderQueueTest, TQueues);
+
+TYPED_TEST(PathfinderQueueTest, popsInCostOrder)
+{
+	for(auto & node : this->nodes)
+		this->push(node, this->randomCost(0));
+
+	std::vector<float> popped;
+	while(!this->subject.empty())
+		popped.push_back(this->pop()->cost);
+
+	EXPECT_EQ(popped.size(), this->nodes.size());
+	EXPECT_TRUE(std::is_sorted(popped.begin(), popped.end()));
+}
+
+TYPED_TEST(PathfinderQueueTest, keepsOrderWhenCostsChange)
+{
+	//same access pattern as Dijkstra: new and updated costs are never lower than last popped one
+	size_t pushed = 0;
+	float last = 0;
+	std::vector<float> popped;
+
+	this->push(this->nodes[pushed++], 0);
+
+	while(!this->subject.empty())
+	{
+		auto node = this->pop();
+		last = node->cost;
+		popped.push_back(last);
+
+		for(int i = 0; i < 3 && pushed < this->nodes.size(); i++)
+			this->push(this->nodes[pushed++], this->randomCost(last));
+
+		for(int i = 0; i < 3; i++)
+		{
+			auto & other = this->nodes[std::uniform_int_distribution<size_t>(0, pushed - 1)(this->rand)];
+			if(other.inQueue)
+			{
+				float cost = this->randomCost(last);
+				if(cost != other.cost)
+					this->setCost(other, cost);
+			}
+		}
+	}
+
+	EXPECT_EQ(popped.size(), this->nodes.size());
+	EXPECT_TRUE(std::is_sorted(popped.begin(), popped.end()));
+}
+
+TYPED_TEST(PathfinderQueueTest, popsEqualCostsAndCheaperLatePush)
+{
+	for(int i = 0; i < 5; i++)
+		this->push(this->nodes[i], 1);
+	this->push(this->nodes[5], 2);
+
+	EXPECT_EQ(this->pop()->cost, 1);
+
+	//cheaper than already popped node, queue must not lose track of it among equal costs
+	this->push(this->nodes[6], 0.5f);
+	EXPECT_EQ(this->pop(), &this->nodes[6]);
+
+	for(int i = 0; i < 4; i++)
+		EXPECT_EQ(this->pop()->cost, 1);
+	EXPECT_EQ(this->pop(), &this->nodes[5]);
+	EXPECT_TRUE(this->subject.empty());
+}
+
+TYPED_TEST(PathfinderQueueTest, reusableAfterClear)
+{
+	this->push(this->nodes[0], 2);
+	this->push(this->nodes[1], 1);
+	this->subject.clear();
+
+	EXPECT_TRUE(this->subject.empty());
+
+	this->push(this->nodes[2], 0.5f);
+	this->push(this->nodes[3], 0.25f);
+
+	EXPECT_EQ(this->pop(), &this->nodes[3]);
+	EXPECT_EQ(this->pop(), &this->nodes[2]);
+	EXPECT_TRUE(this->subject.empty());
+}
@@ -0,0 +1,399 @@
+/*
+ * CBonusSystemNodeTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+#include <chrono>
+
+#include "../../lib/HeroBonus.h"
+
+using namespace testing;
+
+class CBonusSystemNodeTest : public Test
+{
+public:
+	CBonusSystemNode player;
+	CBonusSystemNode hero1;
+	CBonusSystemNode hero2;
+	CBonusSystemNode stack1;
+	CBonusSystemNode stack2;
+	CBonusSystemNode artifact;
+
+	CBonusSystemNodeTest()
+		: player(CBonusSystemNode::PLAYER),
+		hero1(CBonusSystemNode::HERO),
+		hero2(CBonusSystemNode::HERO),
+		stack1(CBonusSystemNode::STACK_INSTANCE),
+		stack2(CBonusSystemNode::STACK_INSTANCE),
+		artifact(CBonusSystemNode::ARTIFACT_INSTANCE)
+	{
+	}
+
+protected:
+	void SetUp() override
+	{
+		hero1.attachTo(&player);
+		hero2.attachTo(&player);
+		stack1.attachTo(&hero1);
+		stack2.attachTo(&hero2);
+
+		player.addNewBonus(makeBonus(Bonus::MORALE, 1));
+		artifact.addNewBonus(makeBonus(Bonus::LUCK, 2));
+	}
+
+	void TearDown() override
+	{
+		stack1.detachFromAll();
+		stack2.detachFromAll();
+		hero1.detachFromAll();
+		hero2.detachFromAll();
+	}
+
+	static std::shared_ptr<Bonus> makeBonus(Bonus::BonusType type, int val)
+	{
+		return std::make_shared<Bonus>(Bonus::PERMANENT, type, Bonus::OTHER, val, 0);
+	}
+
+	std::vector<CBonusSystemNode *> queriedNodes()
+	{
+		return {&hero1, &hero2, &stack1, &stack2};
+	}
+
+	//what AI does for each of its units during turn
+	void queryAll()
+	{
+		for(const CBonusSystemNode * node : queriedNodes())
+		{
+			node->valOfBonuses(Bonus::MORALE);
+			node->valOfBonuses(Bonus::LUCK);
+			node->hasBonusOfType(Bonus::FLYING);
+		}
+	}
+
+	void resetCacheStatistics()
+	{
+		for(CBonusSystemNode * node : queriedNodes())
+			node->resetCacheStatistics();
+	}
+
+	CBonusSystemNode::CacheStatistics getCacheStatistics()
+	{
+		CBonusSystemNode::CacheStatistics ret = {0, 0, 0};
+		for(const CBonusSystemNode * node : queriedNodes())
+		{
+			auto nodeStats = node->getCacheStatistics();
+			ret.requestHits += nodeStats.requestHits;
+			ret.requestMisses += nodeStats.requestMisses;
+			ret.rebuilds += nodeStats.rebuilds;
+		}
+		return ret;
+	}
+};
+
+TEST_F(CBonusSystemNodeTest, queriesInheritedBonuses)
+{
+	EXPECT_EQ(stack1.valOfBonuses(Bonus::MORALE), 1);
+	EXPECT_EQ(stack1.valOfBonuses(Bonus::LUCK), 0);
+
+	hero1.attachTo(&artifact);
+
+	EXPECT_EQ(stack1.valOfBonuses(Bonus::LUCK), 2);
+	EXPECT_EQ(stack2.valOfBonuses(Bonus::LUCK), 0);
+
+	hero1.detachFrom(&artifact);
+
+	EXPECT_EQ(stack1.valOfBonuses(Bonus::LUCK), 0);
+}
+
+TEST_F(CBonusSystemNodeTest, changeInvalidatesOnlyAffectedSubtree)
+{
+	queryAll();
+
+	const int64_t hero2Version = hero2.getTreeVersion();
+	const int64_t stack2Version = stack2.getTreeVersion();
+	const int64_t stack1Version = stack1.getTreeVersion();
+
+	hero1.attachTo(&artifact);
+
+	EXPECT_EQ(hero2.getTreeVersion(), hero2Version);
+	EXPECT_EQ(stack2.getTreeVersion(), stack2Version);
+	EXPECT_NE(stack1.getTreeVersion(), stack1Version);
+
+	resetCacheStatistics();
+	queryAll();
+
+	auto stats = getCacheStatistics();
+	EXPECT_EQ(stats.rebuilds, 2); //hero1 and stack1
+	//type queries are answered from index, only first query on rebuilt node is a miss
+	EXPECT_EQ(stats.requestMisses, 2);
+	EXPECT_EQ(stats.requestHits, 10);
+}
+
+TEST_F(CBonusSystemNodeTest, changeInAncestorInvalidatesDescendants)
+{
+	queryAll();
+
+	player.addNewBonus(makeBonus(Bonus::MORALE, 1));
+
+	resetCacheStatistics();
+	queryAll();
+
+	auto stats = getCacheStatistics();
+	EXPECT_EQ(stats.rebuilds, 4);
+	EXPECT_EQ(stats.requestMisses, 4);
+	EXPECT_EQ(stats.requestHits, 8);
+	EXPECT_EQ(stack2.valOfBonuses(Bonus::MORALE), 2);
+}
+
+TEST_F(CBonusSystemNodeTest, changeReachesSharedDescendantOnce)
+{
+	//stack1 inherits from hero1 directly and through artifact
+	artifact.attachTo(&hero1);
+	stack1.attachTo(&artifact);
+
+	const int64_t stack1Version = stack1.getTreeVersion();
+
+	hero1.addNewBonus(makeBonus(Bonus::MORALE, 1));
+
+	EXPECT_EQ(stack1.getTreeVersion(), stack1Version + 1);
+	EXPECT_EQ(stack1.valOfBonuses(Bonus::MORALE), 2);
+	EXPECT_EQ(stack1.valOfBonuses(Bonus::LUCK), 2);
+
+	stack1.detachFrom(&artifact);
+	artifact.detachFrom(&hero1);
+}
+
+TEST_F(CBonusSystemNodeTest, globalVersionChangesWithAnyNode)
+{
+	const int64_t globalVersion = CBonusSystemNode::getGlobalTreeVersion();
+	const int64_t stack1Version = stack1.getTreeVersion();
+
+	stack2.addNewBonus(makeBonus(Bonus::LUCK, 1));
+
+	EXPECT_EQ(stack1.getTreeVersion(), stack1Version);
+	EXPECT_NE(CBonusSystemNode::getGlobalTreeVersion(), globalVersion);
+}
+
+TEST_F(CBonusSystemNodeTest, scriptedTurnCacheHitRate)
+{
+	resetCacheStatistics();
+
+	for(int day = 0; day < 7; day++)
+	{
+		queryAll();
+		queryAll();
+
+		if(day % 2)
+			hero1.attachTo(&artifact);
+		else if(day > 0)
+			hero1.detachFrom(&artifact);
+	}
+
+	auto stats = getCacheStatistics();
+	//every node is built once, then only hero1 subtree is rebuilt after each artifact move
+	EXPECT_EQ(stats.rebuilds, 4 + 2 * 5);
+	EXPECT_GT(stats.requestHits, stats.requestMisses);
+}
+
+TEST_F(CBonusSystemNodeTest, concurrentQueriesOnSameNode)
+{
+	hero1.attachTo(&artifact);
+
+	std::atomic<int> wrongResults(0);
+	std::vector<boost::thread> threads;
+
+	for(int i = 0; i < 4; i++)
+	{
+		threads.push_back(boost::thread([&]()
+		{
+			for(int j = 0; j < 1000; j++)
+			{
+				if(stack1.valOfBonuses(Bonus::LUCK) != 2 || stack1.valOfBonuses(Selector::type()(Bonus::MORALE)) != 1)
+					wrongResults++;
+			}
+		}));
+	}
+
+	for(auto & thread : threads)
+		thread.join();
+
+	EXPECT_EQ(wrongResults, 0);
+	EXPECT_EQ(stack1.getCacheStatistics().rebuilds, 1);
+}
+
+TEST_F(CBonusSystemNodeTest, concurrentQueriesOnDistinctNodes)
+{
+	const int threadCount = std::max<int>(2, boost::thread::hardware_concurrency());
+	const int queriesPerThread = 10000;
+
+	std::vector<std::unique_ptr<CBonusSystemNode>> stacks;
+	for(int i = 0; i < threadCount; i++)
+	{
+		stacks.push_back(make_unique<CBonusSystemNode>(CBonusSystemNode::STACK_INSTANCE));
+		stacks.back()->attachTo(i % 2 ? &hero1 : &hero2);
+		stacks.back()->addNewBonus(makeBonus(Bonus::LUCK, i));
+	}
+
+	std::atomic<int> wrongResults(0);
+	std::vector<boost::thread> threads;
+
+	for(int i = 0; i < threadCount; i++)
+	{
+		const CBonusSystemNode * stack = stacks[i].get();
+		threads.push_back(boost::thread([&wrongResults, stack, i, queriesPerThread]()
+		{
+			for(int j = 0; j < queriesPerThread; j++)
+			{
+				if(stack->valOfBonuses(Bonus::LUCK) != i || stack->valOfBonuses(Bonus::MORALE) != 1)
+					wrongResults++;
+			}
+		}));
+	}
+
+	for(auto & thread : threads)
+		thread.join();
+
+	EXPECT_EQ(wrongResults, 0);
+	for(auto & stack : stacks)
+	{
+		auto stats = stack->getCacheStatistics();
+		EXPECT_EQ(stats.rebuilds, 1);
+		EXPECT_EQ(stats.requestMisses, 1);
+		EXPECT_EQ(stats.requestHits, 2 * queriesPerThread - 1);
+		stack->detachFromAll();
+	}
+}
+
+//prints throughput of cached queries on distinct nodes for 1..N threads, run with --gtest_also_run_disabled_tests
+//with per-node cache locks it should grow with number of threads up to number of cores
+TEST_F(CBonusSystemNodeTest, DISABLED_concurrentQueriesBenchmark)
+{
+	const int maxThreads = std::max<int>(1, boost::thread::hardware_concurrency());
+	const int queriesPerThread = 200000;
+
+	std::vector<std::unique_ptr<CBonusSystemNode>> stacks;
+	for(int i = 0; i < maxThreads; i++)
+	{
+		stacks.push_back(make_unique<CBonusSystemNode>(CBonusSystemNode::STACK_INSTANCE));
+		stacks.back()->attachTo(i % 2 ? &hero1 : &hero2);
+		stacks.back()->addNewBonus(makeBonus(Bonus::LUCK, i));
+	}
+
+	//not indexed selector, goes through bonus list cache
+	const CSelector notIndexed = Selector::sourceType()(Bonus::OTHER);
+
+	for(int threadCount = 1; threadCount <= maxThreads; threadCount++)
+	{
+		std::vector<boost::thread> threads;
+		auto start = std::chrono::steady_clock::now();
+
+		for(int i = 0; i < threadCount; i++)
+		{
+			const CBonusSystemNode * stack = stacks[i].get();
+			threads.push_back(boost::thread([stack, &notIndexed, queriesPerThread]()
+			{
+				for(int j = 0; j < queriesPerThread; j += 4)
+				{
+					stack->valOfBonuses(Bonus::LUCK);
+					stack->valOfBonuses(Bonus::MORALE);
+					stack->hasBonusOfType(Bonus::FLYING);
+					stack->getBonuses(notIndexed);
+				}
+			}));
+		}
+
+		for(auto & thread : threads)
+			thread.join();
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		const double queries = double(threadCount) * queriesPerThread;
+		std::cout << threadCount << " threads: " << queries / elapsed.count() / 1e6 << " M queries/s" << std::endl;
+	}
+
+	for(auto & stack : stacks)
+		stack->detachFromAll();
+}
+
+TEST_F(CBonusSystemNodeTest, indexedTotalsMatchBonusList)
+{
+	hero1.attachTo(&artifact);
+	hero1.addNewBonus(std::make_shared<Bonus>(Bonus::PERMANENT, Bonus::PRIMARY_SKILL, Bonus::OTHER, 4, 0, PrimarySkill::ATTACK));
+	hero1.addNewBonus(std::make_shared<Bonus>(Bonus::PERMANENT, Bonus::PRIMARY_SKILL, Bonus::OTHER, 50, 1, PrimarySkill::ATTACK, Bonus::PERCENT_TO_ALL));
+	hero1.addNewBonus(std::make_shared<Bonus>(Bonus::PERMANENT, Bonus::PRIMARY_SKILL, Bonus::OTHER, 3, 2, PrimarySkill::DEFENSE, Bonus::INDEPENDENT_MAX));
+	auto ranged = std::make_shared<Bonus>(Bonus::PERMANENT, Bonus::PRIMARY_SKILL, Bonus::OTHER, 7, 3, PrimarySkill::ATTACK);
+	ranged->effectRange = Bonus::ONLY_DISTANCE_FIGHT;
+	hero1.addNewBonus(ranged);
+
+	std::vector<CSelector> selectors =
+	{
+		Selector::type()(Bonus::PRIMARY_SKILL),
+		Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK),
+		Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::DEFENSE),
+		Selector::type()(Bonus::LUCK),
+		Selector::type()(Bonus::FLYING)
+	};
+
+	for(const CBonusSystemNode * node : {&hero1, &stack1})
+	{
+		for(auto & selector : selectors)
+		{
+			BonusList::Totals totals;
+			ASSERT_TRUE(node->getIndexedTotals(totals, selector, nullptr));
+			auto list = node->getAllBonuses(selector, nullptr);
+			EXPECT_EQ(totals.value(), list->totalValue());
+			EXPECT_EQ(totals.count, (int)list->size());
+
+			ASSERT_TRUE(node->getIndexedTotals(totals, selector, Selector::all));
+			list = node->getAllBonuses(selector, Selector::all);
+			EXPECT_EQ(totals.value(), list->totalValue());
+			EXPECT_EQ(totals.count, (int)list->size());
+		}
+	}
+
+	EXPECT_EQ(stack1.valOfBonuses(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK), 6);
+	EXPECT_EQ(hero1.valOfBonuses(Bonus::PRIMARY_SKILL, PrimarySkill::DEFENSE), 3);
+
+	BonusList::Totals totals;
+	EXPECT_FALSE(stack1.getIndexedTotals(totals, Selector::sourceType()(Bonus::OTHER), nullptr));
+	EXPECT_FALSE(stack1.getIndexedTotals(totals, Selector::type()(Bonus::LUCK), Selector::effectRange()(Bonus::ONLY_MELEE_FIGHT)));
+}
+
+TEST_F(CBonusSystemNodeTest, proxiesAreAnsweredFromIndex)
+{
+	CTotalsProxy luck(&stack1, Selector::type()(Bonus::LUCK), 0);
+	CCheckProxy morale(&stack1, Selector::type()(Bonus::MORALE));
+	CCheckProxy flying(&stack1, Selector::type()(Bonus::FLYING));
+
+	hero1.attachTo(&artifact);
+	stack1.resetCacheStatistics();
+
+	EXPECT_EQ(luck.getValue(), 2);
+	EXPECT_TRUE(morale.getHasBonus());
+	EXPECT_FALSE(flying.getHasBonus());
+
+	//only first query rebuilds cache, others do not build lists for their selectors
+	auto stats = stack1.getCacheStatistics();
+	EXPECT_EQ(stats.rebuilds, 1);
+	EXPECT_EQ(stats.requestMisses, 1);
+	EXPECT_EQ(stats.requestHits, 2);
+}
+
+TEST(BonusCacheKeyTest, distinguishesQueries)
+{
+	EXPECT_TRUE(BonusCacheKey().empty());
+	EXPECT_FALSE(BonusCacheKey::type(Bonus::NONE).empty());
+
+	EXPECT_EQ(BonusCacheKey::typeSubtype(Bonus::MORALE, -1), BonusCacheKey::type(Bonus::MORALE));
+	EXPECT_NE(BonusCacheKey::typeSubtype(Bonus::MORALE, 0), BonusCacheKey::type(Bonus::MORALE));
+	EXPECT_NE(BonusCacheKey::typeSubtype(Bonus::MORALE, 1), BonusCacheKey::typeSubtype(Bonus::LUCK, 1));
+	EXPECT_NE(BonusCacheKey::typeSubtypeInfo(Bonus::MORALE, 1, 1), BonusCacheKey::typeSubtype(Bonus::MORALE, 1));
+	EXPECT_NE(BonusCacheKey::source(Bonus::SPELL_EFFECT, 1), BonusCacheKey::source(Bonus::ARTIFACT, 1));
+
+	EXPECT_EQ(BonusCacheKey::named("BonusCacheKeyTest::a"), BonusCacheKey::named("BonusCacheKeyTest::a"));
+	EXPECT_NE(BonusCacheKey::named("BonusCacheKeyTest::a"), BonusCacheKey::named("BonusCacheKeyTest::b"));
+}
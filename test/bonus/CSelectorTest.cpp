@@ -0,0 +1,114 @@
+/*
+ * CSelectorTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "../../lib/HeroBonus.h"
+
+using namespace testing;
+
+class CSelectorTest : public Test
+{
+public:
+	BonusList bonuses;
+
+protected:
+	void SetUp() override
+	{
+		addBonus(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK, Bonus::ARTIFACT, 1, 10);
+		addBonus(Bonus::PRIMARY_SKILL, PrimarySkill::DEFENSE, Bonus::ARTIFACT, 2, 20);
+		addBonus(Bonus::LUCK, 0, Bonus::SPELL_EFFECT, 3, 30);
+		addBonus(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK, Bonus::SECONDARY_SKILL, 4, 40);
+		addBonus(Bonus::MORALE, 0, Bonus::SPELL_EFFECT, 5, 50);
+		bonuses.back()->effectRange = Bonus::ONLY_ENEMY_ARMY;
+	}
+
+	void addBonus(Bonus::BonusType type, TBonusSubtype subtype, Bonus::BonusSource source, ui32 sid, int val)
+	{
+		auto b = std::make_shared<Bonus>(Bonus::PERMANENT, type, source, val, sid, subtype);
+		b->additionalInfo = CAddInfo(sid % 2);
+		bonuses.push_back(b);
+	}
+
+	std::vector<int> selectValues(const CSelector & selector, const CSelector & limit = nullptr)
+	{
+		BonusList out;
+		bonuses.getBonuses(out, selector, limit);
+		std::vector<int> ret;
+		for(auto & b : out)
+			ret.push_back(b->val);
+		return ret;
+	}
+
+	//same query evaluated by calling field tests through lambdas only
+	std::vector<int> selectValuesSlow(const CSelector & selector, const CSelector & limit = nullptr)
+	{
+		CSelector wrapped([selector](const Bonus * b){ return selector(b); });
+		return selectValues(wrapped, limit);
+	}
+};
+
+TEST_F(CSelectorTest, compiledSelectorsMatchFields)
+{
+	auto attack = Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK);
+
+	EXPECT_THAT(selectValues(attack), ElementsAre(10, 40));
+	EXPECT_THAT(selectValues(attack.And(Selector::sourceType()(Bonus::ARTIFACT))), ElementsAre(10));
+	EXPECT_THAT(selectValues(Selector::source(Bonus::SPELL_EFFECT, 3)), ElementsAre(30));
+	EXPECT_THAT(selectValues(Selector::typeSubtypeInfo(Bonus::PRIMARY_SKILL, PrimarySkill::DEFENSE, 0)), ElementsAre(20));
+	EXPECT_THAT(selectValues(Selector::type()(Bonus::PRIMARY_SKILL).And(Selector::info()(0))), ElementsAre(20, 40));
+	EXPECT_THAT(selectValues(Selector::type()(Bonus::MORALE)), ElementsAre());
+	EXPECT_THAT(selectValues(Selector::type()(Bonus::MORALE), Selector::effectRange()(Bonus::ONLY_ENEMY_ARMY)), ElementsAre(50));
+	EXPECT_THAT(selectValues(Selector::all), ElementsAre(10, 20, 30, 40));
+	EXPECT_THAT(selectValues(Selector::none.Or(Selector::type()(Bonus::LUCK))), ElementsAre(30));
+}
+
+TEST_F(CSelectorTest, longConjunctionFallsBackToPredicate)
+{
+	auto selector = Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::ATTACK)
+		.And(Selector::sourceType()(Bonus::SECONDARY_SKILL))
+		.And(Selector::info()(0))
+		.And(Selector::valueType(Bonus::ADDITIVE_VALUE))
+		.And(Selector::effectRange()(Bonus::NO_LIMIT));
+
+	EXPECT_THAT(selectValues(selector), ElementsAre(40));
+}
+
+TEST_F(CSelectorTest, fixedTypeIsDetected)
+{
+	si32 type = -1;
+	EXPECT_TRUE(Selector::typeSubtype(Bonus::LUCK, 0).getFixedField(CSelector::TYPE, type));
+	EXPECT_EQ(type, Bonus::LUCK);
+
+	EXPECT_FALSE(Selector::sourceType()(Bonus::ARTIFACT).getFixedField(CSelector::TYPE, type));
+	EXPECT_FALSE(Selector::type()(Bonus::LUCK).Or(Selector::type()(Bonus::MORALE)).getFixedField(CSelector::TYPE, type));
+}
+
+TEST_F(CSelectorTest, indexedListGivesSameResults)
+{
+	std::vector<std::pair<CSelector, CSelector>> queries =
+	{
+		{Selector::type()(Bonus::PRIMARY_SKILL), nullptr},
+		{Selector::typeSubtype(Bonus::PRIMARY_SKILL, PrimarySkill::DEFENSE), nullptr},
+		{Selector::type()(Bonus::MORALE), Selector::all},
+		{Selector::type()(Bonus::FLYING), nullptr},
+		{Selector::sourceType()(Bonus::SPELL_EFFECT), Selector::all}
+	};
+
+	bonuses.indexByType();
+
+	for(auto & query : queries)
+		EXPECT_EQ(selectValues(query.first, query.second), selectValuesSlow(query.first, query.second));
+
+	EXPECT_THAT(selectValues(Selector::type()(Bonus::PRIMARY_SKILL)), ElementsAre(10, 20, 40));
+
+	addBonus(Bonus::PRIMARY_SKILL, PrimarySkill::KNOWLEDGE, Bonus::ARTIFACT, 6, 60);
+
+	EXPECT_THAT(selectValues(Selector::type()(Bonus::PRIMARY_SKILL)), ElementsAre(10, 20, 40, 60));
+}
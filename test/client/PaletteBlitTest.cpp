@@ -0,0 +1,172 @@
+/*
+ * PaletteBlitTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+
+#include "StdInc.h"
+#include <chrono>
+
+#include "../../client/gui/SDL_PaletteBlit.h"
+#include "../../client/gui/SDL_Pixels.h"
+
+using namespace PaletteBlit;
+
+class PaletteBlitTest : public testing::Test
+{
+public:
+	struct Kernel
+	{
+		TRowBlitter blitter;
+		std::string name;
+	};
+
+	std::mt19937 rng;
+	SDL_Color palette[256];
+
+	void SetUp() override
+	{
+		rng.seed(42);
+		for(auto & color : palette)
+		{
+			color.r = rng();
+			color.g = rng();
+			color.b = rng();
+			color.a = 255;
+		}
+		//transparent, shadow, half-transparent and a few odd values that hit rounding
+		palette[0].a = 0;
+		palette[1].a = 64;
+		palette[2].a = 128;
+		palette[3].a = 1;
+		palette[4].a = 254;
+		palette[5].a = 200;
+	}
+
+	//loop used by blit8bppAlphaTo24bpp before kernels were added
+	void blitRowReference(const ui8 * src, ui8 * dst, int width)
+	{
+		for(int x = 0; x < width; x++)
+		{
+			const SDL_Color & color = palette[src[x]];
+			ColorPutter<4, +1>::PutColorAlphaSwitch(dst, color.r, color.g, color.b, color.a);
+		}
+	}
+
+	//kernels that can run on this CPU
+	std::vector<Kernel> getKernels()
+	{
+		std::vector<Kernel> ret;
+		ret.push_back({&blitRowScalar, "scalar"});
+#ifdef VCMI_PALETTE_BLIT_X86
+		const std::string best = getRowBlitterName();
+		if(best == "SSE2" || best == "AVX2")
+			ret.push_back({&blitRowSSE2, "SSE2"});
+		if(best == "AVX2")
+			ret.push_back({&blitRowAVX2, "AVX2"});
+#endif
+		return ret;
+	}
+
+	ui8 randomIndex()
+	{
+		//mostly transparent and semi-transparent pixels, like in creature sprites
+		int kind = rng() % 10;
+		if(kind < 3)
+			return 0;
+		if(kind < 5)
+			return rng() % 6;
+		return rng() % 256;
+	}
+};
+
+TEST_F(PaletteBlitTest, kernelsMatchColorPutter)
+{
+	for(auto & kernel : getKernels())
+	{
+		for(int iteration = 0; iteration < 20000; iteration++)
+		{
+			//odd widths cover tails not handled by vector code
+			const int width = rng() % 80;
+
+			std::vector<ui8> src(width);
+			std::vector<ui8> dst(width * 4);
+			for(auto & index : src)
+				index = randomIndex();
+			for(auto & byte : dst)
+				byte = rng();
+
+			std::vector<ui8> expected = dst;
+			blitRowReference(src.data(), expected.data(), width);
+
+			kernel.blitter(src.data(), dst.data(), width, palette);
+
+			ASSERT_EQ(dst, expected) << kernel.name << " kernel, width " << width;
+		}
+	}
+}
+
+TEST_F(PaletteBlitTest, selectedKernelMatchesColorPutter)
+{
+	std::vector<ui8> src(256);
+	for(int i = 0; i < 256; i++)
+		src[i] = i;
+
+	std::vector<ui8> dst(src.size() * 4, 77);
+	std::vector<ui8> expected = dst;
+
+	blitRowReference(src.data(), expected.data(), src.size());
+	getRowBlitter()(src.data(), dst.data(), src.size(), palette);
+
+	EXPECT_EQ(dst, expected) << getRowBlitterName();
+}
+
+//prints throughput of each kernel, run with --gtest_also_run_disabled_tests
+TEST_F(PaletteBlitTest, DISABLED_benchmark)
+{
+	//creature-like frame: transparent background, shadow, half-transparent outline and opaque body
+	const int width = 450;
+	const int height = 400;
+	const int repeats = 300;
+
+	std::vector<ui8> creature(width * height);
+	std::vector<ui8> opaque(width * height);
+	for(int y = 0; y < height; y++)
+	{
+		for(int x = 0; x < width; x++)
+		{
+			const int dx = x - width / 2;
+			const int dy = y - height / 2;
+			ui8 index = 0;
+			if(dx * dx / 4 + dy * dy < 120 * 120)
+				index = 10 + (x * 7 + y * 3) % 240;
+			else if(dy > 60 && dy < 110 && dx > -160 && dx < 200)
+				index = 1;
+			else if(dx * dx / 4 + dy * dy < 125 * 125)
+				index = 2;
+			creature[y * width + x] = index;
+			opaque[y * width + x] = 10 + rng() % 240;
+		}
+	}
+
+	std::vector<ui8> target(width * height * 4, 77);
+
+	for(auto frame : {std::make_pair(&creature, "creature"), std::make_pair(&opaque, "opaque")})
+	{
+		for(auto & kernel : getKernels())
+		{
+			auto start = std::chrono::steady_clock::now();
+			for(int i = 0; i < repeats; i++)
+				for(int y = 0; y < height; y++)
+					kernel.blitter(frame.first->data() + y * width, target.data() + y * width * 4, width, palette);
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+			const double pixels = double(repeats) * width * height;
+			std::cout << frame.second << " frame, " << kernel.name << ": " << pixels / elapsed.count() / 1e6 << " Mpx/s" << std::endl;
+		}
+	}
+}
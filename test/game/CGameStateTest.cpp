@@ -16,20 +16,34 @@
 
 #include "../../lib/VCMIDirs.h"
 #include "../../lib/CGameState.h"
+#include "../../lib/CPathfinder.h"
+#include "../../lib/CStopWatch.h"
 #include "../../lib/NetPacks.h"
 #include "../../lib/StartInfo.h"
 
 #include "../../lib/battle/BattleInfo.h"
 #include "../../lib/CStack.h"
 
+#include "../../lib/filesystem/CMemoryBuffer.h"
+#include "../../lib/filesystem/Filesystem.h"
 #include "../../lib/filesystem/ResourceID.h"
 
 #include "../../lib/mapping/CMap.h"
+#include "../../lib/mapping/MapFormatJson.h"
+#include "../../lib/rmg/CMapGenOptions.h"
+#include "../../lib/rmg/CMapGenerator.h"
+
+#include "../../lib/serializer/BinaryDeserializer.h"
+#include "../../lib/serializer/BinarySerializer.h"
 
 #include "../../lib/spells/CSpellHandler.h"
 #include "../../lib/spells/ISpellMechanics.h"
 #include "../../lib/spells/AbilityCaster.h"
 
+#ifdef VCMI_UNIX
+#include <sys/resource.h>
+#endif
+
 class CGameStateTest : public ::testing::Test, public SpellCastEnvironment, public MapListener
 {
 public:
@@ -137,15 +151,23 @@ public:
 	}
 
 	void startTestGame()
+	{
+		startGame(&mapService, "anything");//map name does not matter, map service mocked
+
+		ASSERT_NE(map, nullptr);
+		ASSERT_EQ(map->heroesOnMap.size(), 2);
+	}
+
+	void startGame(const IMapService * service, const std::string & mapname)
 	{
 		StartInfo si;
-		si.mapname = "anything";//does not matter, map service mocked
+		si.mapname = mapname;
 		si.difficulty = 0;
 		si.mapfileChecksum = 0;
 		si.mode = StartInfo::NEW_GAME;
 		si.seedToBeUsed = 42;
 
-		std::unique_ptr<CMapHeader> header = mapService.loadMapHeader(ResourceID(si.mapname));
+		std::unique_ptr<CMapHeader> header = service->loadMapHeader(ResourceID(si.mapname, EResType::MAP));
 
 		ASSERT_NE(header.get(), nullptr);
 
@@ -177,12 +199,45 @@ public:
 		}
 
 
-		gameState->init(&mapService, &si, false);
+		gameState->init(service, &si, false);
+	}
 
-		ASSERT_NE(map, nullptr);
-		ASSERT_EQ(map->heroesOnMap.size(), 2);
+
+	//movement is normally set by server on new turn
+	void restoreMovement(const CGHeroInstance * hero)
+	{
+		SetMovePoints smp;
+		smp.hid = hero->id;
+		smp.val = hero->maxMovePoints(true);
+		gameCallback->sendAndApply(&smp);
 	}
 
+	//paths after incremental update must be same as after full search
+	void expectSamePaths(const CPathsInfo & paths, const CPathsInfo & expected)
+	{
+		for(EPathfindingLayer layer = EPathfindingLayer::LAND; layer < EPathfindingLayer::NUM_LAYERS; layer.advance(1))
+		{
+			if(!expected.hasLayer(layer))
+				continue;
+
+			ASSERT_TRUE(paths.hasLayer(layer));
+
+			for(size_t i = 0; i < expected.nodes[layer].size(); i++)
+			{
+				const CGPathNode & actualNode = paths.nodes[layer][i];
+				const CGPathNode & expectedNode = expected.nodes[layer][i];
+
+				EXPECT_EQ(actualNode.reachable(), expectedNode.reachable()) << expectedNode.coord.toString();
+
+				if(expectedNode.reachable())
+				{
+					EXPECT_EQ(actualNode.turns, expectedNode.turns) << expectedNode.coord.toString();
+					EXPECT_EQ(actualNode.moveRemains, expectedNode.moveRemains) << expectedNode.coord.toString();
+					EXPECT_NEAR(actualNode.getCost(), expectedNode.getCost(), 1e-4) << expectedNode.coord.toString();
+				}
+			}
+		}
+	}
 
 	void startTestBattle(const CGHeroInstance * attacker, const CGHeroInstance * defender)
 	{
@@ -421,3 +476,333 @@ TEST_F(CGameStateTest, updateEntity)
 	gameState->updateEntity(Metatype::CREATURE, 424242, JsonUtils::stringNode("TEST"));
 	EXPECT_EQ(actual.String(), "TEST");
 }
+
+TEST_F(CGameStateTest, incrementalPathsMatchFullSearch)
+{
+	startTestGame();
+
+	const CGHeroInstance * hero = map->heroesOnMap[0];
+	restoreMovement(hero);
+
+	CPathsInfo paths(gameState->getMapSize(), hero);
+	gameState->calculatePaths(hero, paths);
+
+	//step to neighbour tile as server would do
+	const CGPathNode * step = nullptr;
+	for(auto & node : paths.nodes[EPathfindingLayer::LAND])
+	{
+		if(node.reachable() && !node.turns && node.action == CGPathNode::NORMAL && node.theNodeBefore && !node.theNodeBefore->theNodeBefore)
+		{
+			step = &node;
+			break;
+		}
+	}
+	ASSERT_NE(step, nullptr);
+
+	TryMoveHero tmh;
+	tmh.id = hero->id;
+	tmh.result = TryMoveHero::SUCCESS;
+	tmh.start = hero->pos;
+	tmh.end = CGHeroInstance::convertPosition(step->coord, true);
+	tmh.movePoints = step->moveRemains;
+	gameCallback->sendAndApply(&tmh);
+
+	ASSERT_EQ(hero->getPosition(false), step->coord);
+
+	gameState->calculatePaths(hero, paths);
+
+	CPathsInfo expected(gameState->getMapSize(), hero);
+	gameState->calculatePaths(hero, expected);
+
+	expectSamePaths(paths, expected);
+}
+
+TEST_F(CGameStateTest, pathsAfterArmyChangeMatchFullSearch)
+{
+	startTestGame();
+
+	const CGHeroInstance * hero = map->heroesOnMap[0];
+	restoreMovement(hero);
+
+	CPathsInfo paths(gameState->getMapSize(), hero);
+	gameState->calculatePaths(hero, paths);
+
+	const int oldMovePoints = hero->maxMovePoints(true);
+
+	//slow creature lowers movement points of next turns, but not movement left today
+	InsertNewStack ins;
+	ins.army = hero->id;
+	ins.slot = hero->getFreeSlot();
+	ins.type = CreatureID(CreatureID::STONE_GOLEM);
+	ins.count = 1;
+	ASSERT_TRUE(ins.slot.validSlot());
+	gameCallback->sendAndApply(&ins);
+
+	ASSERT_NE(hero->maxMovePoints(true), oldMovePoints);
+
+	gameState->calculatePaths(hero, paths);
+
+	CPathsInfo expected(gameState->getMapSize(), hero);
+	gameState->calculatePaths(hero, expected);
+
+	expectSamePaths(paths, expected);
+}
+
+//Measures pathfinder speed, run with --gtest_also_run_disabled_tests --gtest_filter=*pathfinderBenchmark
+//Maps are taken from VCMI_BENCHMARK_MAPS (';' separated, e.g. "Maps/SomeXLMap;Maps/SomeXXLMap"), test map is used if not set
+TEST_F(CGameStateTest, DISABLED_pathfinderBenchmark)
+{
+	const int iterations = 5;
+
+	std::vector<std::string> mapNames;
+	const char * mapsVar = std::getenv("VCMI_BENCHMARK_MAPS");
+	if(mapsVar)
+		boost::split(mapNames, mapsVar, boost::is_any_of(";"));
+	else
+		mapNames.push_back("");
+
+	CMapService realMapService;
+
+	for(const std::string & mapName : mapNames)
+	{
+		gameState = std::make_shared<CGameState>();
+		gameCallback->setGameState(gameState.get());
+		gameState->preInit(&services);
+		map = nullptr;
+
+		if(mapName.empty())
+			startGame(&mapService, "anything");
+		else
+			startGame(&realMapService, mapName);
+
+		ASSERT_NE(gameState->map, nullptr);
+
+		si64 totalNodes = 0;
+		si64 totalMs = 0;
+
+		for(const CGHeroInstance * hero : gameState->map->heroesOnMap)
+		{
+			restoreMovement(hero);
+
+			CPathsInfo paths(gameState->getMapSize(), hero);
+			CStopWatch timer;
+
+			for(int i = 0; i < iterations; i++)
+				gameState->calculatePaths(hero, paths);
+
+			totalMs += timer.getDiff();
+
+			for(auto & layer : paths.nodes)
+			{
+				for(auto & node : layer)
+				{
+					if(node.reachable())
+						totalNodes += iterations;
+				}
+			}
+		}
+
+		const std::string name = mapName.empty() ? "test map" : mapName;
+		const double nodesPerSecond = totalNodes * 1000.0 / std::max<si64>(totalMs, 1);
+
+		logGlobal->info("Pathfinder benchmark: %s, %d heroes, %d reachable nodes in %d ms, %.0f nodes/s",
+			name, gameState->map->heroesOnMap.size(), totalNodes, totalMs, nodesPerSecond);
+		std::cout << name << ": " << static_cast<si64>(nodesPerSecond) << " nodes/s" << std::endl;
+	}
+}
+
+/// Serves single map kept in memory, used to measure game start without disk access
+class MemoryMapService : public IMapService
+{
+public:
+	MemoryMapService(const std::vector<ui8> & data_, const std::string & name_)
+		: data(data_), name(name_)
+	{
+	}
+
+	std::unique_ptr<CMap> loadMap(const ResourceID & resource) const override
+	{
+		return service.loadMap(data.data(), static_cast<int>(data.size()), name);
+	}
+
+	std::unique_ptr<CMapHeader> loadMapHeader(const ResourceID & resource) const override
+	{
+		return service.loadMapHeader(data.data(), static_cast<int>(data.size()), name);
+	}
+
+	std::unique_ptr<CMap> loadMap(const ui8 * buffer, int size, const std::string & name) const override
+	{
+		return service.loadMap(buffer, size, name);
+	}
+
+	std::unique_ptr<CMapHeader> loadMapHeader(const ui8 * buffer, int size, const std::string & name) const override
+	{
+		return service.loadMapHeader(buffer, size, name);
+	}
+
+	void saveMap(const std::unique_ptr<CMap> & map, boost::filesystem::path fullPath) const override
+	{
+	}
+
+private:
+	const std::vector<ui8> & data;
+	std::string name;
+	CMapService service;
+};
+
+//peak resident set size in KB, 0 if not available
+static si64 peakMemoryUsage()
+{
+#ifdef VCMI_UNIX
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef VCMI_APPLE
+	return usage.ru_maxrss / 1024; //reported in bytes
+#else
+	return usage.ru_maxrss;
+#endif
+#else
+	return 0;
+#endif
+}
+
+static JsonNode benchmarkPhase(si64 ms, ui64 bytes = 0)
+{
+	JsonNode ret;
+	ret["ms"].Integer() = ms;
+	if(bytes)
+	{
+		ret["bytes"].Integer() = static_cast<si64>(bytes);
+		ret["mbPerSecond"].Float() = bytes / 1024.0 / 1024.0 * 1000.0 / std::max<si64>(ms, 1);
+	}
+	return ret;
+}
+
+//Measures map loading, game start and savegame round-trip, run with --gtest_also_run_disabled_tests --gtest_filter=*saveLoadBenchmark
+//Maps of every size are generated with fixed seed, maps from VCMI_BENCHMARK_MAPS (see pathfinderBenchmark) are measured as well
+//Results are written as JSON to VCMI_BENCHMARK_OUTPUT, or to saveLoadBenchmark.json in user cache directory if not set
+TEST_F(CGameStateTest, DISABLED_saveLoadBenchmark)
+{
+	const ui32 seed = 1337;
+	const auto savePath = VCMIDirs::get().userCachePath() / "saveLoadBenchmark.vsgm1";
+
+	struct MapEntry
+	{
+		std::string name;
+		std::vector<ui8> data;
+		si64 generationMs; //negative for maps loaded from disk
+	};
+	std::vector<MapEntry> maps;
+
+	for(int size : {CMapHeader::MAP_SIZE_SMALL, CMapHeader::MAP_SIZE_MIDDLE, CMapHeader::MAP_SIZE_LARGE, CMapHeader::MAP_SIZE_XLARGE})
+	{
+		CMapGenOptions options;
+		options.setWidth(size);
+		options.setHeight(size);
+		options.setHasTwoLevels(true);
+
+		CStopWatch timer;
+		CMapGenerator generator;
+		std::unique_ptr<CMap> generated = generator.generate(&options, seed);
+		generated->name = "Benchmark";
+
+		MapEntry entry;
+		entry.name = boost::str(boost::format("random %dx%d") % size % size);
+		entry.generationMs = timer.getDiff();
+
+		CMemoryBuffer buffer;
+		{
+			CMapSaverJson saver(&buffer);
+			saver.saveMap(generated);
+		}
+		entry.data = buffer.getBuffer();
+		maps.push_back(std::move(entry));
+	}
+
+	const char * mapsVar = std::getenv("VCMI_BENCHMARK_MAPS");
+	if(mapsVar)
+	{
+		std::vector<std::string> mapNames;
+		boost::split(mapNames, mapsVar, boost::is_any_of(";"));
+		for(const std::string & mapName : mapNames)
+		{
+			auto data = CResourceHandler::get()->load(ResourceID(mapName, EResType::MAP))->readAll();
+
+			MapEntry entry;
+			entry.name = mapName;
+			entry.data.assign(data.first.get(), data.first.get() + data.second);
+			entry.generationMs = -1;
+			maps.push_back(std::move(entry));
+		}
+	}
+
+	JsonNode results;
+	results["serializationVersion"].Integer() = SERIALIZATION_VERSION;
+
+	for(const MapEntry & entry : maps)
+	{
+		results["maps"].Vector().push_back(JsonNode());
+		JsonNode & result = results["maps"].Vector().back();
+		result["map"].String() = entry.name;
+		if(entry.generationMs >= 0)
+			result["generate"] = benchmarkPhase(entry.generationMs);
+
+		MemoryMapService memoryMapService(entry.data, entry.name);
+		CStopWatch timer;
+		{
+			auto loaded = memoryMapService.loadMap(ResourceID(entry.name, EResType::MAP));
+			ASSERT_NE(loaded, nullptr);
+		}
+		result["mapLoad"] = benchmarkPhase(timer.getDiff(), entry.data.size());
+
+		gameState = std::make_shared<CGameState>();
+		gameCallback->setGameState(gameState.get());
+		gameState->preInit(&services);
+		map = nullptr;
+
+		timer.update();
+		startGame(&memoryMapService, entry.name);
+		result["gameStart"] = benchmarkPhase(timer.getDiff()); //includes one more map load
+
+		for(auto compression : {CSaveFile::ZLIB_COMPRESSION, CSaveFile::NO_COMPRESSION})
+		{
+			const std::string suffix = compression == CSaveFile::NO_COMPRESSION ? "Uncompressed" : "";
+
+			timer.update();
+			{
+				CSaveFile save(savePath, compression);
+				gameCallback->saveCommonState(save);
+			}
+			const si64 serializeMs = timer.getDiff();
+			CSaveFile::waitForPendingWrites();
+			const si64 writeMs = timer.getDiff();
+			const ui64 fileSize = boost::filesystem::file_size(savePath);
+
+			result["save" + suffix] = benchmarkPhase(serializeMs + writeMs, fileSize);
+			result["save" + suffix]["serializeMs"].Integer() = serializeMs;
+
+			GameCallbackMock loadCallback(this);
+			timer.update();
+			{
+				CLoadFile load(savePath, MINIMAL_SERIALIZATION_VERSION);
+				loadCallback.loadCommonState(load);
+			}
+			result["load" + suffix] = benchmarkPhase(timer.getDiff(), fileSize);
+			delete loadCallback.gameState();
+		}
+		boost::filesystem::remove(savePath);
+
+		result["peakMemoryKB"].Integer() = peakMemoryUsage();
+
+		std::cout << entry.name << ": save " << result["save"]["ms"].Integer() << " ms, load " << result["load"]["ms"].Integer()
+			<< " ms, " << result["save"]["bytes"].Integer() << " bytes (uncompressed " << result["saveUncompressed"]["bytes"].Integer() << ")" << std::endl;
+	}
+
+	boost::filesystem::path outputPath = VCMIDirs::get().userCachePath() / "saveLoadBenchmark.json";
+	if(const char * outputVar = std::getenv("VCMI_BENCHMARK_OUTPUT"))
+		outputPath = outputVar;
+
+	boost::filesystem::ofstream output(outputPath);
+	output << results.toJson();
+	logGlobal->info("Save/load benchmark results written to %s", outputPath.string());
+}
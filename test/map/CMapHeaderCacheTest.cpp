@@ -0,0 +1,103 @@
+/*
+ * CMapHeaderCacheTest.cpp, part of VCMI engine
+ *
+ * Authors: listed in file AUTHORS in main folder
+ *
+ * License: GNU General Public License v2.0 or later
+ * Full text of license available in license.txt file, in main folder
+ *
+ */
+#include "StdInc.h"
+
+#include "../../lib/mapping/CMapHeaderCache.h"
+#include "../../lib/serializer/BinarySerializer.h"
+#include "../../lib/VCMIDirs.h"
+
+class CMapHeaderCacheTest : public ::testing::Test
+{
+public:
+	boost::filesystem::path cacheFile;
+	boost::filesystem::path mapFile;
+
+	CMapHeaderCacheTest()
+		: cacheFile(VCMIDirs::get().userCachePath() / "test_mapHeaders.vcache"),
+		mapFile(VCMIDirs::get().userCachePath() / "test_cached.h3m")
+	{
+	}
+
+protected:
+	void SetUp() override
+	{
+		boost::filesystem::remove(cacheFile);
+		writeMapFile("map");
+	}
+
+	void TearDown() override
+	{
+		CSaveFile::waitForPendingWrites();
+		boost::filesystem::remove(cacheFile);
+		boost::filesystem::remove(mapFile);
+	}
+
+	void writeMapFile(const std::string & content)
+	{
+		boost::filesystem::ofstream file(mapFile, boost::filesystem::ofstream::binary);
+		file << content;
+	}
+
+	void storeHeader(const std::string & name)
+	{
+		CMapHeaderCache cache(cacheFile);
+		CMapHeader header;
+		header.name = name;
+		header.width = CMapHeader::MAP_SIZE_SMALL;
+		cache.put(mapFile, header);
+		cache.save();
+	}
+};
+
+TEST_F(CMapHeaderCacheTest, returnsStoredHeader)
+{
+	storeHeader("Cached");
+
+	CMapHeaderCache cache(cacheFile);
+	auto header = cache.get(mapFile);
+	ASSERT_NE(header, nullptr);
+	EXPECT_EQ(header->name, "Cached");
+	EXPECT_EQ(header->width, CMapHeader::MAP_SIZE_SMALL);
+	EXPECT_EQ(cache.getHits(), 1);
+}
+
+TEST_F(CMapHeaderCacheTest, ignoresChangedFile)
+{
+	storeHeader("Cached");
+	writeMapFile("changed map");
+
+	CMapHeaderCache cache(cacheFile);
+	EXPECT_EQ(cache.get(mapFile), nullptr);
+	EXPECT_EQ(cache.getMisses(), 1);
+}
+
+TEST_F(CMapHeaderCacheTest, dropsUnusedEntriesOnSave)
+{
+	storeHeader("Cached");
+
+	{
+		CMapHeaderCache cache(cacheFile);
+		cache.save();
+	}
+
+	CMapHeaderCache cache(cacheFile);
+	EXPECT_EQ(cache.get(mapFile), nullptr);
+}
+
+TEST_F(CMapHeaderCacheTest, ignoresInvalidCacheFile)
+{
+	{
+		boost::filesystem::ofstream file(cacheFile, boost::filesystem::ofstream::binary);
+		file << "garbage";
+	}
+
+	CMapHeaderCache cache(cacheFile);
+	EXPECT_EQ(cache.get(mapFile), nullptr);
+}